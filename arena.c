@@ -0,0 +1,179 @@
+/**
+ * FILENAME: arena.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Arena allocator for per-puzzle and per-search scratch memory: one
+ *        malloc up front, then allocations that cost an addition and are all
+ *        released together. Each thread keeps a scratch arena that the
+ *        solvers and the minimizer take their state from, so that solving or
+ *        minimizing puzzle after puzzle allocates nothing once it is big
+ *        enough.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int arena_init(arena *a, size_t size)
+ *        void *arena_alloc(arena *a, size_t bytes)
+ *        size_t arena_mark(const arena *a)
+ *        void arena_release(arena *a, size_t mark)
+ *        void arena_destroy(arena *a)
+ *        arena *arena_scratch(arena *local, size_t bytes, size_t *mark)
+ *        void arena_scratch_done(arena *scratch, arena *local, size_t mark)
+ *
+ **/
+
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Scratch arena of each thread, freed when the thread exits */
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+/* Frees the scratch arena of a thread that exits
+Modified parameter :
+-void *a : the arena
+*/
+static void free_scratch(void *a) {
+  arena_destroy(a);
+  free(a);
+}
+
+static void create_scratch_key(void) {
+  pthread_key_create(&scratch_key, free_scratch);
+}
+
+/** Allocates the memory of an arena.
+
+Modified parameter:
+ - arena *a: the arena to set up
+
+Copied parameter:
+ - size_t size: the number of bytes it can hand out
+
+Returns:
+ - int: 0 if the memory could not be allocated
+**/
+int arena_init(arena *a, size_t size) {
+  a->base = malloc(size);
+  a->size = a->base ? size : 0;
+  a->used = 0;
+  return a->base != NULL;
+}
+
+/** Takes bytes from an arena.
+
+Modified parameter:
+ - arena *a: the arena
+
+Copied parameter:
+ - size_t bytes: the number of bytes
+
+Returns:
+ - void*: the memory, or NULL if the arena is full
+**/
+void *arena_alloc(arena *a, size_t bytes) {
+  size_t start = (a->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+  if (start > a->size || bytes > a->size - start) {
+    return NULL;
+  }
+  a->used = start + bytes;
+  return a->base + start;
+}
+
+/** Gets the current position of an arena, to release what follows later.
+
+Copied parameter:
+ - const arena *a: the arena
+
+Returns:
+ - size_t: the mark
+**/
+size_t arena_mark(const arena *a) { return a->used; }
+
+/** Releases everything allocated since a mark (0 releases everything).
+
+Modified parameter:
+ - arena *a: the arena
+
+Copied parameter:
+ - size_t mark: a value returned by arena_mark
+
+No return
+**/
+void arena_release(arena *a, size_t mark) {
+  if (mark < a->used) {
+    a->used = mark;
+  }
+}
+
+/** Frees the memory of an arena.
+
+Modified parameter:
+ - arena *a: the arena
+
+No return
+**/
+void arena_destroy(arena *a) {
+  free(a->base);
+  a->base = NULL;
+  a->size = 0;
+  a->used = 0;
+}
+
+/** Gets scratch memory for one search or one puzzle: the arena of the
+calling thread, grown if it is empty and too small. When it is already in use
+further up the call stack and too small, local is set up with the bytes
+instead. Each call must be paired with arena_scratch_done.
+
+Modified parameters:
+ - arena *local: set up when the arena of the thread cannot be used
+ - size_t *mark: receives where the arena stood, for arena_scratch_done
+
+Copied parameter:
+ - size_t bytes: the bytes needed, padding included
+
+Returns:
+ - arena*: the arena to allocate from, NULL if the memory could not be
+   allocated
+**/
+arena *arena_scratch(arena *local, size_t bytes, size_t *mark) {
+  pthread_once(&scratch_once, create_scratch_key);
+  arena *a = pthread_getspecific(scratch_key);
+
+  if (!a && (a = calloc(1, sizeof(arena)))) {
+    pthread_setspecific(scratch_key, a);
+  }
+  if (a && a->size - a->used < bytes && a->used == 0) {
+    arena_destroy(a);
+    arena_init(a, bytes);
+  }
+  if (!a || a->size - a->used < bytes) {
+    *mark = 0;
+    return arena_init(local, bytes) ? local : NULL;
+  }
+
+  *mark = arena_mark(a);
+  return a;
+}
+
+/** Releases the memory taken by arena_scratch.
+
+Modified parameters:
+ - arena *scratch: the arena returned by arena_scratch
+ - arena *local: the local arena given to arena_scratch
+
+Copied parameter:
+ - size_t mark: the mark set by arena_scratch
+
+No return
+**/
+void arena_scratch_done(arena *scratch, arena *local, size_t mark) {
+  if (scratch == local) {
+    arena_destroy(local);
+  } else {
+    arena_release(scratch, mark);
+  }
+}
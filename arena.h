@@ -0,0 +1,27 @@
+#ifndef ARENA_FILE
+#define ARENA_FILE
+
+#include <stddef.h>
+
+/* Every allocation starts on a multiple of ARENA_ALIGN bytes, so an arena
+needs up to ARENA_ALIGN - 1 bytes of padding per allocation */
+#define ARENA_ALIGN 16
+
+/* Bump allocator for scratch memory that lives as long as one puzzle or one
+search: allocations only move an offset forward, and everything allocated
+after a mark is released at once by going back to it. */
+typedef struct arena {
+  char *base;
+  size_t size;
+  size_t used;
+} arena;
+
+int arena_init(arena *a, size_t size);
+void *arena_alloc(arena *a, size_t bytes);
+size_t arena_mark(const arena *a);
+void arena_release(arena *a, size_t mark);
+void arena_destroy(arena *a);
+arena *arena_scratch(arena *local, size_t bytes, size_t *mark);
+void arena_scratch_done(arena *scratch, arena *local, size_t mark);
+
+#endif
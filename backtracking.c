@@ -3,45 +3,428 @@
 *
 * DESCRIPTION:
 *       Functions that allows us to create a backtracking algorithm.
+*       The search itself runs on packed bitgrids through the incremental
+*       state of solver.c, with the deductions of propagation.c at each node.
 *
 * PUBLIC FUNCTIONS:
-*       int *find_next(int **grid, int grid_size[2]);
+*       int find_next(int **grid, int grid_size[2], int next[2]);
 *       int solve(int **grid, int grid_size[2]);
 *       int **generate_grid(int grid_size[2]);
+*       int count_solutions(int **grid, int grid_size[2], int limit);
+*       int bitgrid_find_next(const bitgrid *bg, int next[2]);
+*       int bitgrid_solve(bitgrid *bg);
+*       int bitgrid_solve_limited(bitgrid *bg, long max_nodes,
+*                                 long max_conflicts);
+*       int bitgrid_count_solutions(const bitgrid *bg, int limit);
+*       int bitgrid_solvable(const bitgrid *bg, long max_nodes);
+*       int search_solvable(solver_state *s, long max_nodes, int probing,
+*                           const bitgrid *hint);
+*       int bitgrid_generate(bitgrid *bg, int grid_size[2], rng *random);
+*       void set_search_strategy(int branching, int values);
+*       void set_solver_backend(int backend);
+*       int search_branch(const solver_state *s, rng *random, int next[2]);
 *
 * AUTHORS: Audrey Damiba & Melissa Lacheb
 **/
 
 
 #include "backtracking.h"
+#include "cdcl.h"
+#include "patterns.h"
+#include "propagation.h"
 #include "utils.h"
 #include "rules.h"
+#include "rng.h"
+#include "solver.h"
+#include "stats.h"
 
 #include <stdlib.h>
 
+/* Nodes a random cell search may visit before it restarts */
+#define RESTART_NODES 2000
+
+/* Restarts of the generator before it gives up on a shape, far above what a
+valid shape needs (under 20 for 64x64) */
+#define GENERATE_RESTARTS 1000
+
+/* Seed of the value choices of the solver: fixed, so that solving a grid
+always gives the same result */
+#define SOLVER_SEED 0
+
+/* Value tried first by search_solvable: the one of a known grid */
+#define VALUE_HINT 2
+
+/* Where the search branches (BRANCH_*) and which value it tries first
+(VALUE_*, with the grid of VALUE_HINT in hint) */
+typedef struct search_strategy {
+  int branching;
+  int values;
+  const bitgrid *hint;
+} search_strategy;
+
+/* Strategy of the solvers, chosen with set_search_strategy */
+static search_strategy solve_strategy = {BRANCH_CONSTRAINED, VALUE_QUOTA,
+                                         NULL};
+
+/* Search of bitgrid_solve, chosen with set_solver_backend */
+static int solver_backend = BACKEND_DFS;
+
+/* Strategy of generation and of the uniqueness checks, never changed: a
+puzzle must only depend on its seed */
+static const search_strategy generate_strategy = {BRANCH_FIRST, VALUE_RANDOM,
+                                                  NULL};
+
+/* Chooses the cell to branch on and the value to try first
+Copied parameters :
+-const solver_state *s : the search state, at a propagation fixpoint
+-const search_strategy *strategy : how to choose
+Modified parameters :
+-rng *random : draws the random values, NULL to try 0 first instead
+-int next[2] : receives the row and column of the cell
+Return : int, the value to try first, -1 if the grid is full
+*/
+static int choose_branch(const solver_state *s,
+                         const search_strategy *strategy, rng *random,
+                         int next[2]) {
+  int found = strategy->branching == BRANCH_CONSTRAINED
+                  ? solver_constrained_cell(s, next)
+                  : solver_next_cell(s, next);
+  if (!found) {
+    return -1;
+  }
+
+  int value = -1;
+  if (strategy->values == VALUE_QUOTA) {
+    value = solver_quota_value(s, next[0], next[1]);
+  } else if (strategy->values == VALUE_HINT) {
+    value = bitgrid_get(strategy->hint, next[0], next[1]);
+  }
+  if (value == -1) {
+    value = random ? rng_int(random, 2) : 0;
+  }
+  return value;
+}
+
+/* Chooses how the solvers branch. Generation always uses the first empty
+cell and random values, so that puzzle IDs keep their puzzle
+Copied parameters :
+-int branching : BRANCH_FIRST (first empty cell in row-major order) or
+ BRANCH_CONSTRAINED (cell of the fullest row and column)
+-int values : VALUE_RANDOM or VALUE_QUOTA (the value the row and the column
+ need the most, random on ties)
+*/
+void set_search_strategy(int branching, int values) {
+  solve_strategy.branching = branching;
+  solve_strategy.values = values;
+}
+
+/* Chooses the search behind bitgrid_solve, and so behind solve, the solving
+stream and the puzzle service. Generation and the uniqueness checks always
+use the depth-first search
+Copied parameter :
+-int backend : BACKEND_DFS or BACKEND_CDCL
+*/
+void set_solver_backend(int backend) { solver_backend = backend; }
+
+/* Chooses the cell to branch on and the value to try first with the
+strategy of the solvers, for the searches of other files
+Copied parameter :
+-const solver_state *s : the search state, at a propagation fixpoint
+Modified parameters :
+-rng *random : draws the random values, NULL to try 0 first instead
+-int next[2] : receives the row and column of the cell
+Return : int, the value to try first, -1 if the grid is full
+*/
+int search_branch(const solver_state *s, rng *random, int next[2]) {
+  return choose_branch(s, &solve_strategy, random, next);
+}
+
 /* Finds in a grid the position of the first empty cell encountered 
 Copied parameters : 
 -int **grid : a 2D array represents a grid
 _int grid_size[2] : contains the size of the grid in the X and Y dimension
+Modified parameter :
+-int next[2] : receives the row and column of the cell, -1 if the grid is full
 Return :
-int* next
+int, 1 if an empty cell was found
 */
-int *find_next(int **grid, int grid_size[2]) {
-  int *next = malloc(sizeof(int) * 2);
+int find_next(int **grid, int grid_size[2], int next[2]) {
+  bitgrid bg;
+
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return bitgrid_find_next(&bg, next);
+}
+
+/* Finds in a packed grid the position of the first empty cell encountered
+Copied parameter :
+-const bitgrid *bg : the packed grid
+Modified parameter :
+-int next[2] : receives the row and column of the cell, -1 if the grid is full
+Return :
+int, 1 if an empty cell was found
+*/
+int bitgrid_find_next(const bitgrid *bg, int next[2]) {
+  line_t full = line_mask(bg->size[1]);
+
+  for (int i = 0; i < bg->size[0]; i++) {
+    line_t empty = ~bg->row_filled[i] & full;
+    if (empty) {
+      next[0] = i;
+      next[1] = __builtin_ctzll(empty);
+      return 1;
+    }
+  }
+
   next[0] = -1;
   next[1] = -1;
+  return 0;
+}
+
+/* Recursive search on the incremental state: every node first propagates
+the deduction rules to a fixpoint, then branches on the next empty cell. The
+caller undoes everything assigned below its trail mark
+Modified parameters :
+-solver_state *s : the search state
+-long *budget : nodes left before giving up, NULL for no limit
+-rng *random : draws the value tried first at each branching
+Copied parameters :
+-int probing : whether to probe single cells after propagation, which costs
+ two propagations per empty cell but solves most puzzles without branching
+-const search_strategy *strategy : how to branch
+Return :
+int
+*/
+static int search(solver_state *s, long *budget, rng *random, int probing,
+                  const search_strategy *strategy) {
+  if (budget && (*budget)-- <= 0) {
+    return 0;
+  }
+  STATS_INC(nodes);
 
-  for (int i = 0; i < grid_size[0]; i++) {
-    for (int j = 0; j < grid_size[1]; j++) {
-      if (grid[i][j] == -1) {
-        next[0] = i;
-        next[1] = j;
-        return next;
+  if (!propagate(s, RULES_ALL) || (probing && !probe(s, RULES_ALL))) {
+    return 0;
+  }
+
+  int next[2];
+  int val = choose_branch(s, strategy, random, next);
+  if (val == -1) {
+    return 1;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    int mark = s->trail_len;
+    if (solver_assign(s, next[0], next[1], val)) {
+      STATS_DESCEND();
+      int found = search(s, budget, random, probing, strategy);
+      STATS_ASCEND();
+      if (found) {
+        return 1;
       }
     }
+
+    STATS_INC(backtracks);
+    solver_undo(s, mark);
+    val = 1 - val;
+  }
+
+  return 0;
+}
+
+/* Solve the packed grid automatically according to the rules, giving up
+after a budget. The search restarts with twice the node budget each time it
+runs out, so that one bad random choice near the root cannot trap it in a
+huge subtree; a search that ends within its budget has proven there is no
+solution. With the CDCL backend, the grid is solved by cdcl_solve instead
+Modified parameter :
+-bitgrid *bg : the packed grid, filled in place
+Copied parameters :
+-long max_nodes : the nodes of all the runs after which the depth-first
+search gives up, -1 for no limit
+-long max_conflicts : the conflicts after which the CDCL backend gives up, -1
+for no limit
+Return :
+int, 1 if solved, 0 if there is no solution, -1 if the search gave up
+*/
+int bitgrid_solve_limited(bitgrid *bg, long max_nodes, long max_conflicts) {
+  solver_state s;
+  rng random;
+  int solved = 0;
+  long left = max_nodes;
+
+  if (solver_backend == BACKEND_CDCL) {
+    return cdcl_solve(bg, max_conflicts);
+  }
+  STATS_START_SEARCH(timer);
+
+  rng_init(&random, SOLVER_SEED);
+  for (long run = RESTART_NODES;; run *= 2) {
+    long allowed = max_nodes >= 0 && left < run ? left : run;
+    long budget = allowed;
+    if (!solver_load(&s, bg)) {
+      break;
+    }
+    if (search(&s, &budget, &random, 1, &solve_strategy)) {
+      *bg = s.grid;
+      solved = 1;
+      break;
+    }
+    if (budget >= 0) {
+      break;
+    }
+    if (max_nodes >= 0 && (left -= allowed) <= 0) {
+      solved = -1;
+      break;
+    }
   }
 
-  return next;
+  STATS_STOP_SEARCH(timer);
+  return solved;
+}
+
+/* Solve the packed grid automatically according to the rules, without a
+budget (see bitgrid_solve_limited)
+Modified parameter :
+-bitgrid *bg : the packed grid, filled in place
+Return :
+int
+*/
+int bitgrid_solve(bitgrid *bg) {
+  return bitgrid_solve_limited(bg, -1, -1) == 1;
+}
+
+/* Tells whether a packed grid has a solution, giving up after max_nodes
+nodes. It branches like generation, since the uniqueness checks of the
+generator rely on it
+Copied parameters :
+-const bitgrid *bg : the packed grid
+-long max_nodes : the number of nodes after which the search gives up
+Return :
+int, 1 if a solution exists, 0 if there is none, -1 if the search gave up
+*/
+int bitgrid_solvable(const bitgrid *bg, long max_nodes) {
+  solver_state s;
+  rng random;
+  long budget = max_nodes;
+  int solvable = 0;
+  STATS_START_SEARCH(timer);
+
+  rng_init(&random, SOLVER_SEED);
+  if (solver_load(&s, bg)) {
+    if (search(&s, &budget, &random, 0, &generate_strategy)) {
+      solvable = 1;
+    } else {
+      solvable = budget < 0 ? -1 : 0;
+    }
+  }
+
+  STATS_STOP_SEARCH(timer);
+  return solvable;
+}
+
+/* Tells whether a search state can be completed, giving up after max_nodes
+nodes. The cells it assigns stay on the trail, so the caller can undo them
+and keep the state for another search. A solution close to a known grid is
+found first by trying the value of that grid at every branching
+Modified parameter :
+-solver_state *s : the search state
+Copied parameters :
+-long max_nodes : the number of nodes after which the search gives up, -1
+ for no limit
+-int probing : whether to probe single cells at every node
+-const bitgrid *hint : a full grid whose values are tried first, NULL to
+ branch like the solvers
+Return :
+int, 1 if a solution exists, 0 if there is none, -1 if the search gave up
+*/
+int search_solvable(solver_state *s, long max_nodes, int probing,
+                    const bitgrid *hint) {
+  search_strategy strategy = solve_strategy;
+  rng random;
+  long budget = max_nodes;
+  STATS_START_SEARCH(timer);
+
+  if (hint) {
+    strategy.values = VALUE_HINT;
+    strategy.hint = hint;
+  }
+  rng_init(&random, SOLVER_SEED);
+  int solvable = search(s, max_nodes < 0 ? NULL : &budget, &random, probing,
+                        &strategy);
+  if (!solvable && max_nodes >= 0 && budget < 0) {
+    solvable = -1;
+  }
+
+  STATS_STOP_SEARCH(timer);
+  return solvable;
+}
+
+/* Counts the solutions below the current node, stopping as soon as limit
+solutions have been found
+Modified parameters :
+-solver_state *s : the search state
+-int *count : number of solutions found so far
+Copied parameter :
+-int limit : the number of solutions after which the search stops
+*/
+static void count_search(solver_state *s, int *count, int limit) {
+  STATS_INC(nodes);
+  if (!propagate(s, RULES_ALL) || !probe(s, RULES_ALL)) {
+    return;
+  }
+
+  int next[2];
+  int val = choose_branch(s, &solve_strategy, NULL, next);
+  if (val == -1) {
+    (*count)++;
+    return;
+  }
+
+  for (int i = 0; i < 2 && *count < limit; i++) {
+    int mark = s->trail_len;
+    if (solver_assign(s, next[0], next[1], val)) {
+      STATS_DESCEND();
+      count_search(s, count, limit);
+      STATS_ASCEND();
+    }
+    STATS_INC(backtracks);
+    solver_undo(s, mark);
+    val = 1 - val;
+  }
+}
+
+/* Counts the solutions of a packed grid, up to limit
+Copied parameters :
+-const bitgrid *bg : the packed grid
+-int limit : the search stops once limit solutions are found
+Return :
+int, the number of solutions found (at most limit)
+*/
+int bitgrid_count_solutions(const bitgrid *bg, int limit) {
+  solver_state s;
+  int count = 0;
+  STATS_START_SEARCH(timer);
+
+  if (solver_load(&s, bg)) {
+    count_search(&s, &count, limit);
+  }
+
+  STATS_STOP_SEARCH(timer);
+  return count;
+}
+
+/* Counts the solutions of a grid, up to limit. count_solutions(grid, size, 2)
+tells whether a puzzle has a unique solution
+Copied parameters :
+-int **grid : a 2D array represents a grid, -1 for empty cells
+_int grid_size[2] : contains the size of the grid in the X and Y dimension
+-int limit : the search stops once limit solutions are found
+Return :
+int, the number of solutions found (at most limit)
+*/
+int count_solutions(int **grid, int grid_size[2], int limit) {
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return bitgrid_count_solutions(&bg, limit);
 }
 
 /* Solve the grid automatically according to the rules
@@ -52,29 +435,63 @@ Return :
 int
 */
 int solve(int **grid, int grid_size[2]) {
-  int *next = find_next(grid, grid_size);
-  if (next[0] == -1) {
-    return 1;
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+
+  int solved = bitgrid_solve(&bg);
+  if (solved) {
+    bitgrid_to_grid(&bg, grid);
   }
 
-  int val = rand() % 2;
-  for (int i = 0; i < 2; i++) {
-    grid[next[0]][next[1]] = val;
+  return solved;
+}
 
-    if (is_valid_grid(grid, grid_size, 0)) {
-      if (solve(grid, grid_size)) {
-        return 1;
+/* Generates a random solved packed grid. Small sizes choose whole rows from
+the cached line table; larger ones use the cell search, restarted with new
+random choices whenever it spends RESTART_NODES nodes without finishing, since
+an unlucky early choice can otherwise cost an exponential amount of work. A
+search that ends within its budget proves that the shape has no valid grid
+(such as 2x4, whose columns cannot all differ), and the generator gives up
+after GENERATE_RESTARTS restarts. The grid only depends on the size and on the
+state of random
+Modified parameters :
+-bitgrid *bg : receives the grid
+-rng *random : the generator the random choices are drawn from
+Copied parameter :
+_int grid_size[2] : contains the size of the grid in the X and Y dimension
+Return :
+int, whether a grid was found
+*/
+int bitgrid_generate(bitgrid *bg, int grid_size[2], rng *random) {
+  bitgrid_init(bg, grid_size);
+  if (grid_size[0] % 2 || grid_size[1] % 2) {
+    return 0;
+  }
+
+  STATS_START_SEARCH(timer);
+  int solved = bitgrid_solve_rows(bg, random);
+
+  if (solved == -1) {
+    solver_state s;
+    solved = 0;
+    for (int restart = 0; restart < GENERATE_RESTARTS; restart++) {
+      long budget = RESTART_NODES;
+      solver_load(&s, bg);
+      solved = search(&s, &budget, random, 0, &generate_strategy);
+      if (solved || budget >= 0) {
+        break;
       }
     }
-
-    grid[next[0]][next[1]] = -1;
-    val = 1 - val;
+    if (solved) {
+      *bg = s.grid;
+    }
   }
 
-  return 0;
+  STATS_STOP_SEARCH(timer);
+  return solved;
 }
 
-/* Create and generate a solved grid
+/* Create and generate a solved grid, with the generator of the calling thread
 Copied parameters : 
 _int grid_size[2] : contains the size of the grid in the X and Y dimension
 Return :
@@ -82,8 +499,11 @@ int** grid
 */
 int **generate_grid(int grid_size[2]) {
   int **grid = create_grid(grid_size, -1);
-  solve(grid, grid_size);
+  bitgrid bg;
+
+  if (bitgrid_generate(&bg, grid_size, rng_thread())) {
+    bitgrid_to_grid(&bg, grid);
+  }
 
   return grid;
 }
-
@@ -1,8 +1,38 @@
 #ifndef BACKTRACKING_FILE
 #define BACKTRACKING_FILE
 
-int *find_next(int **grid, int grid_size[2]);
+#include "bitboard.h"
+#include "rng.h"
+#include "solver.h"
+
+/* Cell the solvers branch on */
+#define BRANCH_FIRST 0
+#define BRANCH_CONSTRAINED 1
+
+/* Value the solvers try first */
+#define VALUE_RANDOM 0
+#define VALUE_QUOTA 1
+
+/* Search behind bitgrid_solve: depth-first with restarts, or conflict-driven
+clause learning (cdcl.h) */
+#define BACKEND_DFS 0
+#define BACKEND_CDCL 1
+
+int find_next(int **grid, int grid_size[2], int next[2]);
 int solve(int **grid, int grid_size[2]);
 int **generate_grid(int grid_size[2]);
+int count_solutions(int **grid, int grid_size[2], int limit);
+
+int bitgrid_find_next(const bitgrid *bg, int next[2]);
+int bitgrid_solve(bitgrid *bg);
+int bitgrid_solve_limited(bitgrid *bg, long max_nodes, long max_conflicts);
+int bitgrid_count_solutions(const bitgrid *bg, int limit);
+int bitgrid_solvable(const bitgrid *bg, long max_nodes);
+int search_solvable(solver_state *s, long max_nodes, int probing,
+                    const bitgrid *hint);
+int bitgrid_generate(bitgrid *bg, int grid_size[2], rng *random);
+void set_search_strategy(int branching, int values);
+void set_solver_backend(int backend);
+int search_branch(const solver_state *s, rng *random, int next[2]);
 
-#endif
\ No newline at end of file
+#endif
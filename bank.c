@@ -0,0 +1,290 @@
+/**
+ * FILENAME: bank.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Puzzle banks: binary files holding many puzzles of one size with
+ *        their solutions at 2 bits per cell, an index of record offsets and
+ *        the seed and difficulty of each puzzle. Banks are read through mmap,
+ *        so opening one costs the same whatever its size and puzzle k is
+ *        decoded without reading any other record.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int bank_create(bank_writer *writer, const char *path,
+ *                        int grid_size[2], uint32_t count)
+ *        int bank_put(bank_writer *writer, uint32_t k,
+ *                     const bitgrid *solution, const bitgrid *puzzle,
+ *                     const bank_meta *meta)
+ *        int bank_finish(bank_writer *writer)
+ *        int bank_open(puzzle_bank *bank, const char *path)
+ *        int bank_get(const puzzle_bank *bank, uint32_t k, bitgrid *solution,
+ *                     bitgrid *puzzle, bank_meta *meta)
+ *        void bank_close(puzzle_bank *bank)
+ *
+ **/
+
+#include "bank.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Size of a record of a grid_size puzzle, rounded up to 8 bytes */
+static uint32_t record_bytes(int grid_size[2]) {
+  uint32_t cells = (uint32_t)(grid_size[0] * grid_size[1]);
+  uint32_t bytes = sizeof(bank_meta) + (cells + 3) / 4;
+  return (bytes + 7) & ~7u;
+}
+
+/* Writes a whole buffer at an offset of a file
+Copied parameters :
+-int fd : the file
+-const void *data, size_t size : the buffer
+-uint64_t offset : where it goes
+Return : int, 0 on a write error
+*/
+static int write_at(int fd, const void *data, size_t size, uint64_t offset) {
+  const char *bytes = data;
+
+  while (size > 0) {
+    ssize_t done = pwrite(fd, bytes, size, (off_t)offset);
+    if (done <= 0) {
+      return 0;
+    }
+    bytes += done;
+    size -= done;
+    offset += done;
+  }
+  return 1;
+}
+
+/** Creates a bank file with room for count puzzles and writes its header and
+index.
+
+Modified parameter:
+ - bank_writer *writer: receives the open bank
+
+Copied parameters:
+ - const char *path: the file to create
+ - int grid_size[2]: contains the size of the grids in the X and Y dimension
+ - uint32_t count: the number of puzzles
+
+Returns:
+ - int: 0 if the file could not be written
+**/
+int bank_create(bank_writer *writer, const char *path, int grid_size[2],
+                uint32_t count) {
+  bank_header *h = &writer->header;
+
+  memset(h, 0, sizeof(bank_header));
+  memcpy(h->magic, BANK_MAGIC, sizeof(h->magic));
+  h->rows = grid_size[0];
+  h->cols = grid_size[1];
+  h->count = count;
+  h->record_bytes = record_bytes(grid_size);
+  h->index_offset = sizeof(bank_header);
+  h->data_offset = h->index_offset + (uint64_t)count * sizeof(uint64_t);
+
+  writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (writer->fd < 0) {
+    return 0;
+  }
+
+  int ok = write_at(writer->fd, h, sizeof(bank_header), 0) &&
+           ftruncate(writer->fd, (off_t)(h->data_offset +
+                                         (uint64_t)count * h->record_bytes)) ==
+               0;
+
+  /* The index is written in chunks so that no buffer grows with count */
+  uint64_t chunk[512];
+  for (uint32_t k = 0; ok && k < count; k += 512) {
+    uint32_t n = count - k < 512 ? count - k : 512;
+    for (uint32_t q = 0; q < n; q++) {
+      chunk[q] = h->data_offset + (uint64_t)(k + q) * h->record_bytes;
+    }
+    ok = write_at(writer->fd, chunk, n * sizeof(uint64_t),
+                  h->index_offset + (uint64_t)k * sizeof(uint64_t));
+  }
+
+  if (!ok) {
+    close(writer->fd);
+    writer->fd = -1;
+  }
+  return ok;
+}
+
+/** Writes puzzle k of a bank. Several threads may write different puzzles of
+the same bank at the same time.
+
+Modified parameter:
+ - bank_writer *writer: the bank
+
+Copied parameters:
+ - uint32_t k: index of the puzzle
+ - const bitgrid *solution: the solved grid
+ - const bitgrid *puzzle: the clues, a subset of the solution
+ - const bank_meta *meta: the seed and difficulty of the puzzle
+
+Returns:
+ - int: 0 on a write error
+**/
+int bank_put(bank_writer *writer, uint32_t k, const bitgrid *solution,
+             const bitgrid *puzzle, const bank_meta *meta) {
+  const bank_header *h = &writer->header;
+  unsigned char record[sizeof(bank_meta) + MAX_GRID_SIZE * MAX_GRID_SIZE / 4];
+  unsigned char *cells = record + sizeof(bank_meta);
+
+  if (k >= h->count) {
+    return 0;
+  }
+
+  memset(record, 0, h->record_bytes);
+  memcpy(record, meta, sizeof(bank_meta));
+  for (uint32_t i = 0; i < h->rows; i++) {
+    for (uint32_t j = 0; j < h->cols; j++) {
+      uint32_t c = i * h->cols + j;
+      int bits = (int)((solution->row_value[i] >> j) & 1) |
+                 (int)((puzzle->row_filled[i] >> j) & 1) << 1;
+      cells[c / 4] |= bits << (c % 4 * 2);
+    }
+  }
+
+  return write_at(writer->fd, record, h->record_bytes,
+                  h->data_offset + (uint64_t)k * h->record_bytes);
+}
+
+/** Closes a bank being written.
+
+Modified parameter:
+ - bank_writer *writer: the bank
+
+Returns:
+ - int: 0 if the file could not be completed
+**/
+int bank_finish(bank_writer *writer) {
+  int ok = writer->fd >= 0 && close(writer->fd) == 0;
+  writer->fd = -1;
+  return ok;
+}
+
+/** Maps a bank file and checks its header and index bounds.
+
+Modified parameter:
+ - puzzle_bank *bank: receives the open bank
+
+Copied parameter:
+ - const char *path: the bank file
+
+Returns:
+ - int: 0 if the file cannot be read or is not a valid bank
+**/
+int bank_open(puzzle_bank *bank, const char *path) {
+  memset(bank, 0, sizeof(puzzle_bank));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(bank_header)) {
+    close(fd);
+    return 0;
+  }
+
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return 0;
+  }
+  madvise(map, st.st_size, MADV_RANDOM);
+
+  bank->map = map;
+  bank->map_size = st.st_size;
+
+  const bank_header *h = map;
+  int grid_size[2] = {(int)h->rows, (int)h->cols};
+  if (memcmp(h->magic, BANK_MAGIC, sizeof(h->magic)) || h->rows == 0 ||
+      h->cols == 0 || h->rows > MAX_GRID_SIZE || h->cols > MAX_GRID_SIZE ||
+      h->record_bytes < record_bytes(grid_size) || h->index_offset % 8 ||
+      h->index_offset + (uint64_t)h->count * sizeof(uint64_t) >
+          bank->map_size) {
+    bank_close(bank);
+    return 0;
+  }
+
+  bank->size[0] = h->rows;
+  bank->size[1] = h->cols;
+  bank->count = h->count;
+  bank->record_bytes = h->record_bytes;
+  bank->index = (const uint64_t *)(bank->map + h->index_offset);
+  return 1;
+}
+
+/** Decodes puzzle k of a bank.
+
+Copied parameters:
+ - const puzzle_bank *bank: the open bank
+ - uint32_t k: index of the puzzle
+
+Modified parameters:
+ - bitgrid *solution: receives the solved grid, may be NULL
+ - bitgrid *puzzle: receives the clues, may be NULL
+ - bank_meta *meta: receives the seed and difficulty, may be NULL
+
+Returns:
+ - int: 0 if k is out of range or its record is outside the file
+**/
+int bank_get(const puzzle_bank *bank, uint32_t k, bitgrid *solution,
+             bitgrid *puzzle, bank_meta *meta) {
+  if (k >= bank->count || bank->index[k] > bank->map_size ||
+      bank->map_size - bank->index[k] < bank->record_bytes) {
+    return 0;
+  }
+
+  const unsigned char *record = bank->map + bank->index[k];
+  const unsigned char *cells = record + sizeof(bank_meta);
+  int grid_size[2] = {bank->size[0], bank->size[1]};
+
+  if (meta) {
+    memcpy(meta, record, sizeof(bank_meta));
+  }
+  if (solution) {
+    bitgrid_init(solution, grid_size);
+  }
+  if (puzzle) {
+    bitgrid_init(puzzle, grid_size);
+  }
+
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      int c = i * grid_size[1] + j;
+      int bits = cells[c / 4] >> (c % 4 * 2);
+      if (solution) {
+        bitgrid_set(solution, i, j, bits & 1);
+      }
+      if (puzzle && (bits & 2)) {
+        bitgrid_set(puzzle, i, j, bits & 1);
+      }
+    }
+  }
+  return 1;
+}
+
+/** Unmaps a bank.
+
+Modified parameter:
+ - puzzle_bank *bank: the bank
+
+No return
+**/
+void bank_close(puzzle_bank *bank) {
+  if (bank->map) {
+    munmap((void *)bank->map, bank->map_size);
+  }
+  memset(bank, 0, sizeof(puzzle_bank));
+}
@@ -0,0 +1,64 @@
+#ifndef BANK_FILE
+#define BANK_FILE
+
+#include "bitboard.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BANK_MAGIC "TKZBANK1"
+
+/* Layout of a bank file, in the byte order of the machine that wrote it:
+ - a bank_header,
+ - the index: count offsets (uint64_t) of the records, from the file start,
+ - the records: a bank_meta, then 2 bits per cell, row after row, 4 cells per
+   byte from the low bits: bit 0 is the value of the cell in the solution and
+   bit 1 tells whether the cell is a clue of the puzzle. */
+typedef struct bank_header {
+  char magic[8];
+  uint32_t rows;
+  uint32_t cols;
+  uint32_t count;
+  uint32_t record_bytes;
+  uint64_t index_offset;
+  uint64_t data_offset;
+} bank_header;
+
+/* Metadata stored with each puzzle */
+typedef struct bank_meta {
+  uint64_t seed;
+  uint32_t score;
+  uint8_t tier;
+  uint8_t reserved[3];
+} bank_meta;
+
+/* A bank being written: records can be put in any order, from several
+threads, since each one goes to its own place in the file */
+typedef struct bank_writer {
+  int fd;
+  bank_header header;
+} bank_writer;
+
+/* A bank opened for reading: the whole file is mapped, nothing is parsed
+until a puzzle is asked for */
+typedef struct puzzle_bank {
+  const unsigned char *map;
+  size_t map_size;
+  int size[2];
+  uint32_t count;
+  uint32_t record_bytes;
+  const uint64_t *index;
+} puzzle_bank;
+
+int bank_create(bank_writer *writer, const char *path, int grid_size[2],
+                uint32_t count);
+int bank_put(bank_writer *writer, uint32_t k, const bitgrid *solution,
+             const bitgrid *puzzle, const bank_meta *meta);
+int bank_finish(bank_writer *writer);
+
+int bank_open(puzzle_bank *bank, const char *path);
+int bank_get(const puzzle_bank *bank, uint32_t k, bitgrid *solution,
+             bitgrid *puzzle, bank_meta *meta);
+void bank_close(puzzle_bank *bank);
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * FILENAME: batch.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Non-interactive generation of many puzzles with a pool of worker
+ *        threads. Each puzzle is written as soon as it is ready, as one line
+ *        "<puzzle> <solution>" where cells are '0', '1' or '.' row after row,
+ *        followed by " <tier> <score>" when the puzzles are rated, or stored
+ *        in a puzzle bank with its seed and rating. Puzzles can also be made
+ *        minimal, with no clue that could be removed.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int generate_batch(int count, int grid_size[2], int threads,
+ *                           uint64_t seed, int rate, int minimal, FILE *out,
+ *                           bank_writer *bank)
+ *
+ **/
+
+#include "batch.h"
+#include "backtracking.h"
+#include "difficulty.h"
+#include "generator.h"
+#include "minimize.h"
+#include "rng.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct batch_job {
+  int count;
+  int claimed;
+  int written;
+  int *grid_size;
+  uint64_t seed;
+  int rate;
+  int minimal;
+  FILE *out;
+  bank_writer *bank;
+  pthread_mutex_t lock;
+} batch_job;
+
+/* Claims one puzzle of the job
+Modified parameter :
+-batch_job *job : the job, to be locked by the caller
+Return : int, index of the puzzle, -1 once every puzzle is claimed
+*/
+static int claim_puzzle(batch_job *job) {
+  if (job->claimed >= job->count) {
+    return -1;
+  }
+  return job->claimed++;
+}
+
+/* Writes one puzzle as a line of text
+Copied parameters :
+-const batch_job *job : the job
+-const bitgrid *solution, const bitgrid *puzzle : the puzzle and its solution
+-const difficulty_report *report : its rating, NULL if it is not rated
+Modified parameter :
+-char *line : buffer of 2 * MAX_GRID_SIZE * MAX_GRID_SIZE + 32 characters
+*/
+static void format_line(const batch_job *job, const bitgrid *solution,
+                        const bitgrid *puzzle, const difficulty_report *report,
+                        char *line) {
+  int cells = job->grid_size[0] * job->grid_size[1];
+
+  bitgrid_to_string(puzzle, line);
+  line[cells] = ' ';
+  bitgrid_to_string(solution, line + cells + 1);
+
+  int len = 2 * cells + 1;
+  if (report) {
+    len += sprintf(line + len, " %s %d", tier_name(report->tier),
+                   report->score);
+  }
+  line[len] = '\n';
+  line[len + 1] = '\0';
+}
+
+/* Worker thread: generates puzzles until every puzzle of the job is claimed.
+Puzzle k is generated from rng_derive(seed, k), whatever the thread that
+claims it, so a puzzle can be made again from its ID alone
+Modified parameter :
+-void *arg : the batch_job
+Return : NULL
+*/
+static void *batch_worker(void *arg) {
+  batch_job *job = arg;
+  char line[2 * MAX_GRID_SIZE * MAX_GRID_SIZE + 32];
+
+  pthread_mutex_lock(&job->lock);
+  int k = claim_puzzle(job);
+  pthread_mutex_unlock(&job->lock);
+
+  while (k >= 0) {
+    bitgrid solution, puzzle;
+    difficulty_report report;
+    uint64_t seed = rng_derive(job->seed, (uint64_t)k);
+
+    int ok;
+    if (job->minimal) {
+      rng random;
+      rng_init(&random, seed);
+      ok = bitgrid_generate(&solution, job->grid_size, &random);
+      if (ok) {
+        bitgrid_minimal_puzzle(&solution, &puzzle, &random, 1);
+      }
+    } else {
+      ok = generate_puzzle(seed, job->grid_size, &solution, &puzzle);
+    }
+    int rated =
+        ok && (job->rate || job->bank) && rate_puzzle(&puzzle, &report);
+
+    if (ok && job->bank) {
+      bank_meta meta = {seed, rated ? report.score : 0,
+                        rated ? report.tier : 0, {0}};
+      ok = bank_put(job->bank, k, &solution, &puzzle, &meta);
+    } else if (ok) {
+      format_line(job, &solution, &puzzle, rated ? &report : NULL, line);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    if (ok && !job->bank) {
+      fputs(line, job->out);
+    }
+    job->written += ok;
+    k = claim_puzzle(job);
+    pthread_mutex_unlock(&job->lock);
+  }
+
+  stats_flush();
+  return NULL;
+}
+
+/* Generates count unique puzzles with threads workers and streams them to out,
+or stores them in a bank
+Copied parameters :
+-int count : the number of puzzles
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+-int threads : the number of worker threads
+-uint64_t seed : seed of the run, from which the seed of each puzzle is derived
+-int rate : whether to append the difficulty tier and score to each line
+-int minimal : whether to make minimal puzzles instead of the puzzles of the
+ seeds (which are the ones of the puzzle IDs)
+Modified parameters :
+-FILE *out : where the puzzles are written as text, when bank is NULL
+-bank_writer *bank : where the puzzles are stored, NULL to write text
+Return : int, the number of puzzles written
+*/
+int generate_batch(int count, int grid_size[2], int threads, uint64_t seed,
+                   int rate, int minimal, FILE *out, bank_writer *bank) {
+  batch_job job;
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+
+  job.count = count;
+  job.claimed = 0;
+  job.written = 0;
+  job.grid_size = grid_size;
+  job.seed = seed;
+  job.rate = rate;
+  job.minimal = minimal;
+  job.out = out;
+  job.bank = bank;
+  pthread_mutex_init(&job.lock, NULL);
+  for (int t = 0; t < threads; t++) {
+    pthread_create(&workers[t], NULL, batch_worker, &job);
+  }
+  for (int t = 0; t < threads; t++) {
+    pthread_join(workers[t], NULL);
+  }
+  pthread_mutex_destroy(&job.lock);
+
+  free(workers);
+  return job.written;
+}
@@ -0,0 +1,12 @@
+#ifndef BATCH_FILE
+#define BATCH_FILE
+
+#include "bank.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+int generate_batch(int count, int grid_size[2], int threads, uint64_t seed,
+                   int rate, int minimal, FILE *out, bank_writer *bank);
+
+#endif
@@ -0,0 +1,556 @@
+/**
+ * FILENAME: bench.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Benchmark harness, built by "make bench". Times grid generation,
+ *        solving, validation (one grid, and batches of VALIDATE_BATCH grids),
+ *        mask generation (random, unique and minimal) and full puzzle
+ *        generation for each size, plus the solver on a fixed corpus of hard
+ *        puzzles. Every sample is seeded from a fixed seed so that two
+ *        versions of the program are measured on the same inputs. Results are
+ *        printed as a table and can be written as CSV and JSON.
+ *
+ **/
+
+#include "backtracking.h"
+#include "bench_corpus.h"
+#include "bitboard.h"
+#include "constants.h"
+#include "generator.h"
+#include "kernels.h"
+#include "minimize.h"
+#include "parallel.h"
+#include "rng.h"
+#include "rules.h"
+#include "utils.h"
+#include "validate.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SEED 20240601
+#define DEFAULT_BUDGET_MS 200
+/* Sizes measured by default: the menu sizes and a few larger ones, enough to
+track regressions in under a minute; --sizes picks others */
+#define DEFAULT_SIZES "4,6,8,10,12,16,24,32"
+#define MIN_SAMPLES 3
+#define MAX_SAMPLES 10000
+#define MAX_RESULTS 512
+#define VALIDATE_BATCH 1024
+#define STRATEGY_COUNT 4
+/* Largest size of the minimal_mask benchmark: the checks of the minimizer are
+never cut short, and take seconds from 24x24 up */
+#define MINIMAL_MAX_SIZE 16
+
+/* Inputs of one sample, built before the clock starts */
+typedef struct bench_input {
+  int grid_size[2];
+  int **solution;
+  int **puzzle;
+} bench_input;
+
+/* Latencies of one benchmark, in nanoseconds */
+typedef struct bench_result {
+  char name[32];
+  int size;
+  int samples;
+  double total;
+  double mean;
+  double p50;
+  double p99;
+  double max;
+} bench_result;
+
+typedef void (*bench_setup)(bench_input *in);
+typedef int (*bench_run)(bench_input *in);
+
+/* Branching strategy of the solver, the default one first */
+typedef struct bench_strategy {
+  const char *name;
+  int branching;
+  int values;
+} bench_strategy;
+
+static const bench_strategy strategies[STRATEGY_COUNT] = {
+    {"mcv/quota", BRANCH_CONSTRAINED, VALUE_QUOTA},
+    {"mcv/random", BRANCH_CONSTRAINED, VALUE_RANDOM},
+    {"first/quota", BRANCH_FIRST, VALUE_QUOTA},
+    {"first/random", BRANCH_FIRST, VALUE_RANDOM},
+};
+
+static bench_result results[MAX_RESULTS];
+static int result_count = 0;
+static const bench_puzzle *current_corpus = NULL;
+static line_t batch_rows[VALIDATE_BATCH * MAX_GRID_SIZE];
+static uint64_t batch_pass[VALIDATE_BATCH / 64];
+/* Workers of the parallel solver benchmarks, none when 1 */
+static int solve_threads = 1;
+
+/* Reads the monotonic clock
+Return : double, the time in nanoseconds
+*/
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* Frees the grids of a sample
+Modified parameter :
+-bench_input *in : the sample
+*/
+static void release_input(bench_input *in) {
+  free_grid(in->solution);
+  free_grid(in->puzzle);
+  in->solution = NULL;
+  in->puzzle = NULL;
+}
+
+/* Builds a puzzle with a single solution and keeps both grids
+Modified parameter :
+-bench_input *in : the sample
+*/
+static void setup_puzzle(bench_input *in) {
+  in->solution = generate_grid(in->grid_size);
+  int **mask = generate_unique_mask(in->solution, in->grid_size);
+  in->puzzle = get_grid_from_mask(mask, in->solution, in->grid_size);
+  free_grid(mask);
+}
+
+/* Builds a solved grid
+Modified parameter :
+-bench_input *in : the sample
+*/
+static void setup_solution(bench_input *in) {
+  in->solution = generate_grid(in->grid_size);
+}
+
+/* Copies the current corpus puzzle into the sample
+Modified parameter :
+-bench_input *in : the sample
+*/
+static void setup_corpus(bench_input *in) {
+  in->puzzle = create_grid(in->grid_size, -1);
+  for (int i = 0; i < in->grid_size[0]; i++) {
+    for (int j = 0; j < in->grid_size[1]; j++) {
+      char c = current_corpus->cells[i * in->grid_size[1] + j];
+      if (c == '0' || c == '1') {
+        in->puzzle[i][j] = c - '0';
+      }
+    }
+  }
+}
+
+/* Builds a solved grid and packs VALIDATE_BATCH copies of it, every other one
+with a flipped cell so that half of the batch is invalid
+Modified parameter :
+-bench_input *in : the sample
+*/
+static void setup_batch(bench_input *in) {
+  bitgrid bg;
+
+  in->solution = generate_grid(in->grid_size);
+  bitgrid_from_grid(&bg, in->solution, in->grid_size);
+  for (int g = 0; g < VALIDATE_BATCH; g++) {
+    for (int i = 0; i < in->grid_size[0]; i++) {
+      batch_rows[g * in->grid_size[0] + i] = bg.row_value[i];
+    }
+    batch_rows[g * in->grid_size[0]] ^= g % 2;
+  }
+}
+
+static int run_generate(bench_input *in) {
+  in->solution = generate_grid(in->grid_size);
+  return is_solved(in->solution, in->grid_size);
+}
+
+static int run_validate(bench_input *in) {
+  return is_valid_grid(in->solution, in->grid_size, 0);
+}
+
+static int run_validate_batch(bench_input *in) {
+  return validate_batch(batch_rows, VALIDATE_BATCH, in->grid_size,
+                        batch_pass, NULL) == VALIDATE_BATCH / 2;
+}
+
+static int run_mask(bench_input *in) {
+  in->puzzle = generate_mask(in->grid_size);
+  return 1;
+}
+
+static int run_unique_mask(bench_input *in) {
+  in->puzzle = generate_unique_mask(in->solution, in->grid_size);
+  return 1;
+}
+
+static int run_minimal_mask(bench_input *in) {
+  in->puzzle = generate_minimal_mask(in->solution, in->grid_size);
+  return 1;
+}
+
+static int run_solve(bench_input *in) {
+  return solve(in->puzzle, in->grid_size) &&
+         is_solved(in->puzzle, in->grid_size);
+}
+
+static int run_solve_parallel(bench_input *in) {
+  bitgrid bg;
+  bitgrid_from_grid(&bg, in->puzzle, in->grid_size);
+  return bitgrid_solve_parallel(&bg, solve_threads) && bitgrid_is_solved(&bg);
+}
+
+static int run_puzzle(bench_input *in) {
+  in->solution = generate_grid(in->grid_size);
+  int **mask = generate_unique_mask(in->solution, in->grid_size);
+  in->puzzle = get_grid_from_mask(mask, in->solution, in->grid_size);
+  free_grid(mask);
+  return 1;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted latencies
+Copied parameters :
+-const double *sorted : the latencies, in increasing order
+-int count : the number of latencies
+-double p : the percentile, between 0 and 1
+Return : double
+*/
+static double percentile(const double *sorted, int count, double p) {
+  int rank = (int)(p * count + 0.999999);
+  if (rank < 1) {
+    rank = 1;
+  }
+  return sorted[rank - 1];
+}
+
+/* Times one operation on fresh inputs until the time budget is spent. The
+budget covers building the inputs too, which can cost more than the operation
+(a unique puzzle for every solve sample). Sample k is always seeded with
+seed + k, so its input does not depend on how many samples the machine had
+time for
+Copied parameters :
+-const char *name : name of the benchmark
+-int size : size of the grids
+-bench_setup setup : builds the input of a sample, may be NULL
+-bench_run run : the timed operation
+-uint64_t seed : seed of the first sample
+-double budget_ns : time budget of the benchmark
+Return : int, 0 if the operation returned a wrong result
+*/
+static int bench_one(const char *name, int size, bench_setup setup,
+                     bench_run run, uint64_t seed, double budget_ns) {
+  static double latencies[MAX_SAMPLES];
+  bench_result *r = &results[result_count++];
+  int ok = 1;
+  double begin = now_ns();
+
+  memset(r, 0, sizeof(bench_result));
+  snprintf(r->name, sizeof(r->name), "%s", name);
+  r->size = size;
+
+  while (r->samples < MAX_SAMPLES &&
+         (r->samples < MIN_SAMPLES || now_ns() - begin < budget_ns)) {
+    bench_input in = {{size, size}, NULL, NULL};
+
+    rng_seed(seed + r->samples);
+    if (setup) {
+      setup(&in);
+    }
+
+    double start = now_ns();
+    int valid = run(&in);
+    double elapsed = now_ns() - start;
+
+    if (!valid) {
+      fprintf(stderr, "%s %dx%d: wrong result on sample %d\n", name, size,
+              size, r->samples);
+      ok = 0;
+    }
+    release_input(&in);
+    latencies[r->samples++] = elapsed;
+    r->total += elapsed;
+  }
+
+  qsort(latencies, r->samples, sizeof(double), compare_double);
+  r->mean = r->total / r->samples;
+  r->p50 = percentile(latencies, r->samples, 0.50);
+  r->p99 = percentile(latencies, r->samples, 0.99);
+  r->max = latencies[r->samples - 1];
+
+  printf("%-24s %5dx%-3d %8d %14.1f %12.2f %12.2f %12.2f %12.2f\n", r->name,
+         size, size, r->samples, r->samples / (r->total / 1e9), r->mean / 1e3,
+         r->p50 / 1e3, r->p99 / 1e3, r->max / 1e3);
+  fflush(stdout);
+  return ok;
+}
+
+/* Times an operation with the size-specialized kernels, then with the
+generic ones too when compare is set (the name is then followed by
+"generic")
+Copied parameters :
+-const char *name : name of the benchmark
+-int size : size of the grids
+-bench_setup setup : builds the inputs of a sample, may be NULL
+-bench_run run : the timed operation
+-uint64_t seed : seed of the first sample
+-double budget_ns : time budget of each kind of kernel
+-int compare : whether to time the generic kernels
+Return : int, 0 if the operation returned a wrong result
+*/
+static int bench_kernels(const char *name, int size, bench_setup setup,
+                         bench_run run, uint64_t seed, double budget_ns,
+                         int compare) {
+  int ok = bench_one(name, size, setup, run, seed, budget_ns);
+
+  if (compare) {
+    char full_name[32];
+    snprintf(full_name, sizeof(full_name), "%s generic", name);
+    set_specialized_kernels(0);
+    ok &= bench_one(full_name, size, setup, run, seed, budget_ns);
+    set_specialized_kernels(1);
+  }
+  return ok;
+}
+
+/* Times the solver on puzzles made by setup, with the default strategy only,
+or with each strategy when compare is set (the name is then followed by the
+strategy), then with the CDCL backend when backends is set (the name is then
+followed by "cdcl") and with the parallel solver when solve_threads is above 1
+(the name is then followed by the number of threads and "t")
+Copied parameters :
+-const char *name : name of the benchmark
+-int size : size of the grids
+-bench_setup setup : builds the puzzle of a sample
+-uint64_t seed : seed of the first sample
+-double budget_ns : time budget of each strategy
+-int compare : whether to time every strategy
+-int kernels : whether to time the generic kernels too
+-int backends : whether to time the CDCL backend too
+Return : int, 0 if a solver returned a wrong result
+*/
+static int bench_strategies(const char *name, int size, bench_setup setup,
+                            uint64_t seed, double budget_ns, int compare,
+                            int kernels, int backends) {
+  int ok = 1;
+
+  for (int t = 0; t < (compare ? STRATEGY_COUNT : 1); t++) {
+    char full_name[32];
+    snprintf(full_name, sizeof(full_name), compare ? "%s %s" : "%s", name,
+             strategies[t].name);
+    set_search_strategy(strategies[t].branching, strategies[t].values);
+    ok &= bench_kernels(full_name, size, setup, run_solve, seed, budget_ns,
+                        kernels);
+  }
+
+  set_search_strategy(strategies[0].branching, strategies[0].values);
+
+  if (backends) {
+    char full_name[32];
+    snprintf(full_name, sizeof(full_name), "%s cdcl", name);
+    set_solver_backend(BACKEND_CDCL);
+    ok &= bench_one(full_name, size, setup, run_solve, seed, budget_ns);
+    set_solver_backend(BACKEND_DFS);
+  }
+
+  if (solve_threads > 1) {
+    char full_name[32];
+    snprintf(full_name, sizeof(full_name), "%s %dt", name, solve_threads);
+    ok &= bench_one(full_name, size, setup, run_solve_parallel, seed,
+                    budget_ns);
+  }
+  return ok;
+}
+
+/* Writes the results as CSV, latencies in microseconds
+Copied parameter :
+-const char *path : the output file
+Return : int, 0 if the file could not be written
+*/
+static int write_csv(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    return 0;
+  }
+
+  fprintf(f, "benchmark,size,samples,throughput_per_s,mean_us,p50_us,p99_us,"
+             "max_us\n");
+  for (int k = 0; k < result_count; k++) {
+    bench_result *r = &results[k];
+    fprintf(f, "%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n", r->name, r->size,
+            r->samples, r->samples / (r->total / 1e9), r->mean / 1e3,
+            r->p50 / 1e3, r->p99 / 1e3, r->max / 1e3);
+  }
+  fclose(f);
+  return 1;
+}
+
+/* Writes the results as JSON, latencies in microseconds
+Copied parameters :
+-const char *path : the output file
+-uint64_t seed : the seed of the run
+Return : int, 0 if the file could not be written
+*/
+static int write_json(const char *path, uint64_t seed) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    return 0;
+  }
+
+  fprintf(f, "{\n  \"seed\": %llu,\n  \"results\": [\n",
+          (unsigned long long)seed);
+  for (int k = 0; k < result_count; k++) {
+    bench_result *r = &results[k];
+    fprintf(f,
+            "    {\"benchmark\": \"%s\", \"size\": %d, \"samples\": %d, "
+            "\"throughput_per_s\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, "
+            "\"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+            r->name, r->size, r->samples, r->samples / (r->total / 1e9),
+            r->mean / 1e3, r->p50 / 1e3, r->p99 / 1e3, r->max / 1e3,
+            k + 1 < result_count ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return 1;
+}
+
+/* Reads a comma-separated list of even sizes
+Copied parameter :
+-const char *list : the list, e.g. "8,12,16"
+Modified parameter :
+-int *sizes : receives the sizes
+Return : int, the number of sizes, 0 if the list is invalid
+*/
+static int read_sizes(const char *list, int *sizes) {
+  int count = 0;
+
+  while (*list) {
+    char *end;
+    long size = strtol(list, &end, 10);
+    if (end == list || size < 2 || size > MAX_GRID_SIZE || size % 2 ||
+        count == MAX_GRID_SIZE) {
+      return 0;
+    }
+    sizes[count++] = (int)size;
+    list = *end == ',' ? end + 1 : end;
+    if (*end && *end != ',') {
+      return 0;
+    }
+  }
+  return count;
+}
+
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n\n"
+          "  --sizes LIST   comma-separated even sizes (default: %s)\n"
+          "  --budget MS    time spent on each benchmark (default %d)\n"
+          "  --seed X       seed of the first sample (default %d)\n"
+          "  --csv FILE     write the results as CSV\n"
+          "  --json FILE    write the results as JSON\n"
+          "  --no-corpus    skip the fixed corpus of hard puzzles\n"
+          "  --strategies   time the solver with every branching strategy\n"
+          "                 (cell: mcv or first, value: quota or random)\n"
+          "  --kernels      time validation and solving with the generic\n"
+          "                 kernels too, next to the size-specialized ones\n"
+          "  --backends     time the solver with the CDCL backend too\n"
+          "  --threads T    time the parallel solver with T threads too\n",
+          program, DEFAULT_SIZES, DEFAULT_BUDGET_MS, DEFAULT_SEED);
+}
+
+int main(int argc, char **argv) {
+  int sizes[MAX_GRID_SIZE], size_count = 0, corpus = 1, compare = 0;
+  int kernels = 0, backends = 0;
+  double budget_ns = DEFAULT_BUDGET_MS * 1e6;
+  uint64_t seed = DEFAULT_SEED;
+  const char *csv_path = NULL, *json_path = NULL;
+
+  size_count = read_sizes(DEFAULT_SIZES, sizes);
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--sizes") && i + 1 < argc) {
+      size_count = read_sizes(argv[++i], sizes);
+      if (!size_count) {
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+      budget_ns = atof(argv[++i]) * 1e6;
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+      csv_path = argv[++i];
+    } else if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+      json_path = argv[++i];
+    } else if (!strcmp(argv[i], "--no-corpus")) {
+      corpus = 0;
+    } else if (!strcmp(argv[i], "--strategies")) {
+      compare = 1;
+    } else if (!strcmp(argv[i], "--kernels")) {
+      kernels = 1;
+    } else if (!strcmp(argv[i], "--backends")) {
+      backends = 1;
+    } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      solve_threads = atoi(argv[++i]);
+      if (solve_threads < 1) {
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int ok = 1;
+  printf("%-24s %9s %8s %14s %12s %12s %12s %12s\n", "benchmark", "size",
+         "samples", "ops/s", "mean(us)", "p50(us)", "p99(us)", "max(us)");
+
+  for (int k = 0; k < size_count; k++) {
+    int size = sizes[k];
+    uint64_t base = seed + (uint64_t)size * 1000003;
+
+    ok &= bench_one("generate_grid", size, NULL, run_generate, base,
+                    budget_ns);
+    ok &= bench_one("is_valid_grid", size, setup_solution, run_validate, base,
+                    budget_ns);
+    ok &= bench_kernels("validate_batch", size, setup_batch,
+                        run_validate_batch, base, budget_ns, kernels);
+    ok &= bench_one("mask", size, NULL, run_mask, base, budget_ns);
+    ok &= bench_one("unique_mask", size, setup_solution, run_unique_mask,
+                    base, budget_ns);
+    if (size <= MINIMAL_MAX_SIZE) {
+      ok &= bench_one("minimal_mask", size, setup_solution, run_minimal_mask,
+                      base, budget_ns);
+    }
+    ok &= bench_strategies("solve", size, setup_puzzle, base, budget_ns,
+                           compare, kernels, backends);
+    ok &= bench_one("puzzle", size, NULL, run_puzzle, base, budget_ns);
+  }
+
+  for (int k = 0; corpus && k < BENCH_CORPUS_SIZE; k++) {
+    char name[32];
+    snprintf(name, sizeof(name), "corpus_%02d", k + 1);
+    current_corpus = &bench_corpus[k];
+    ok &= bench_strategies(name, current_corpus->size, setup_corpus, seed,
+                           budget_ns, compare, kernels, backends);
+  }
+
+  if (csv_path) {
+    ok &= write_csv(csv_path);
+  }
+  if (json_path) {
+    ok &= write_json(json_path, seed);
+  }
+  return ok ? 0 : 1;
+}
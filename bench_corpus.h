@@ -0,0 +1,198 @@
+#ifndef BENCH_CORPUS_FILE
+#define BENCH_CORPUS_FILE
+
+/* Fixed puzzles for the solver benchmark, so that solver changes are always
+compared on the same inputs. Each one has a single solution and was picked
+among generated puzzles for being among the slowest to solve. Cells are '0',
+'1' or '.' (empty), row after row. */
+typedef struct bench_puzzle {
+  int size;
+  const char *cells;
+} bench_puzzle;
+
+static const bench_puzzle bench_corpus[] = {
+  {8,
+   ".0..1.1."
+   ".....1.."
+   "0.1....1"
+   "....1..1"
+   "1....1.."
+   "..1....."
+   "0..0.1.."
+   "...01..1"},
+  {8,
+   "0.00...."
+   ".1...0.1"
+   "...0...."
+   ".1...0.."
+   "1..0...."
+   ".....11."
+   "........"
+   ".....1.."},
+  {8,
+   "......10"
+   ".......0"
+   ".11....."
+   "1.0.0.1."
+   ".......1"
+   "......1."
+   "0...1..0"
+   "..1....."},
+  {12,
+   "..0..1...00."
+   "...1....1..."
+   ".0..0.....0."
+   ".0..0...01.."
+   "..0........."
+   ".0.0......11"
+   ".....10.0..1"
+   ".1......0..."
+   "..1.11....1."
+   "............"
+   "1..1..0.1..."
+   ".....1....0."},
+  {12,
+   "..0..1..0.1."
+   "1..1........"
+   ".......0.1.1"
+   ".0...11....."
+   "....11....1."
+   "1.......00.."
+   "........0..."
+   "...........1"
+   "......1....."
+   "1..1......1."
+   "..0........0"
+   ".1.........."},
+  {12,
+   "1........1.1"
+   "......0....."
+   "1.......0..1"
+   ".0.0...0...."
+   ".........11."
+   "11.0.00...1."
+   ".11...0.11.."
+   "....0......."
+   "...........0"
+   ".0....00...."
+   ".0...0......"
+   "........0.0."},
+  {12,
+   "...11.....1."
+   ".......0.0.0"
+   "1...00......"
+   ".....00..0.."
+   "..........11"
+   "......0....."
+   "..00....0..."
+   ".1..0.10...."
+   "0......01..."
+   "............"
+   "00.0...11..."
+   "..1........0"},
+  {16,
+   "................"
+   ".1...0.....0..0."
+   "..0...11..1....1"
+   "......1......1.."
+   "0...........1..."
+   "....1..1.1....11"
+   "......0.....0..."
+   "...1.00.......1."
+   "..0.......0..1.."
+   "1.......0.1....."
+   ".......1.1.0..0."
+   "01.0...1.....0.."
+   "..............00"
+   ".1...1....0.1..1"
+   "0...0...0.....0."
+   "..00...10....1.."},
+  {16,
+   ".1.........11..."
+   "..1....1.1...0.."
+   ".1....0..1..0..."
+   ".....1....0....."
+   "....0...0......."
+   "....0...0.00...."
+   ".....1....0.1..1"
+   "1.1............1"
+   "....0..1..1..0.."
+   ".0......0...1..."
+   "1.....1...00...."
+   ".....0.........."
+   "..0..0......0.00"
+   "..0...........0."
+   ".1..11.....0...."
+   "0..11...0.1...00"},
+  {16,
+   "...0....0...00.1"
+   "00.....1.....0.."
+   ".11..01....0...."
+   "........01.1...0"
+   "..0.....0...0..."
+   "....10....0....."
+   "...0..11....1..."
+   "1.........1....."
+   "11....1.....1..0"
+   "....1.11.....11."
+   "1.1....1........"
+   "..1.........1..1"
+   "....0...0......."
+   "1.0.1..........."
+   "1........1..11.."
+   ".......00...11.."},
+  {24,
+   "...1.0..1..1..1..1..0.1."
+   "...0.....1......0..00..."
+   ".....11.....11........11"
+   ".1...1.1..1............."
+   ".11....1.11..1.........."
+   "..1...0..1.............."
+   ".1.1....1..0.0......11.."
+   "0......0..0..........1.."
+   "..11.....1..0...11..0..1"
+   "....0..11...0...11....1."
+   ".............1......1..1"
+   ".....0..........0......."
+   "0.1.........1.....0..0.."
+   ".....0....0......0..1.1."
+   ".....0.1......11..1.1..1"
+   "..0...0....00.....11..1."
+   ".........11............."
+   "...1.11.0.....1.0......."
+   "..11......1.00...1.1...."
+   "0.....1.....0......11..."
+   "00....1......00..1....1."
+   ".................1.1.0.."
+   "0.....11....1........1.."
+   "0.11.11.0....00..1.1...."},
+  {24,
+   "..11.0....0..0.00.0....0"
+   "1.................11.1.."
+   ".0.1..10...01..1.....1.."
+   "......1...1.1.0........1"
+   ".....0............11...1"
+   "0..............0.0..0..."
+   "........11...1.....1...."
+   ".1.....0..00............"
+   ".1.1....1......0.01...00"
+   "....00....11.1....1...0."
+   "01...00........1........"
+   ".1......0.1.1.1.0.1....."
+   ".....................1.."
+   "11..1.11..00.1.1.1.1...."
+   "........0.......0...0..."
+   "..........11.......1..11"
+   ".0.00.1.....10.........1"
+   ".........1..1..1.0......"
+   ".1.1..........1...10...."
+   ".......1....1..0.......0"
+   "...........0...0...0...."
+   "....1....11.1..........."
+   ".......0.....0..1..0...0"
+   "............1..0...00.0."},
+};
+
+#define BENCH_CORPUS_SIZE (int)(sizeof(bench_corpus) / sizeof(bench_corpus[0]))
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * FILENAME: bitboard.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Packed representation of Takuzu grids: one word of "filled" bits and
+ *        one word of "value" bits per row, mirrored in column-major order.
+ *
+ * PUBLIC FUNCTIONS:
+ *        void bitgrid_init(bitgrid *bg, int grid_size[2])
+ *        void bitgrid_from_grid(bitgrid *bg, int **grid, int grid_size[2])
+ *        void bitgrid_to_grid(const bitgrid *bg, int **grid)
+ *        line_t pack_line(int *line, int line_size, line_t *value)
+ *        void bitgrid_to_string(const bitgrid *bg, char *str)
+ *        int bitgrid_from_string(bitgrid *bg, const char *str)
+ *
+ **/
+
+#include "bitboard.h"
+
+#include <string.h>
+
+/** Resets a packed grid to an empty grid of size grid_size. Only the lines
+of that size are cleared, so that small grids do not pay for the largest one.
+
+Modified parameter:
+ - bitgrid *bg: the packed grid to reset
+
+Copied parameter:
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+No return
+**/
+void bitgrid_init(bitgrid *bg, int grid_size[2]) {
+  memset(bg->row_filled, 0, grid_size[0] * sizeof(line_t));
+  memset(bg->row_value, 0, grid_size[0] * sizeof(line_t));
+  memset(bg->col_filled, 0, grid_size[1] * sizeof(line_t));
+  memset(bg->col_value, 0, grid_size[1] * sizeof(line_t));
+  bg->size[0] = grid_size[0];
+  bg->size[1] = grid_size[1];
+}
+
+/** Packs an int grid (-1 for empty cells) into a bitgrid.
+
+Modified parameter:
+ - bitgrid *bg: the packed grid to fill
+
+Copied parameters:
+ - int **grid: 2D grid to pack
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+No return
+**/
+void bitgrid_from_grid(bitgrid *bg, int **grid, int grid_size[2]) {
+  bitgrid_init(bg, grid_size);
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      if (grid[i][j] == 0 || grid[i][j] == 1) {
+        bitgrid_set(bg, i, j, grid[i][j]);
+      }
+    }
+  }
+}
+
+/** Unpacks a bitgrid into an int grid, writing -1 for empty cells.
+
+Copied parameter:
+ - const bitgrid *bg: the packed grid
+
+Modified parameter:
+ - int **grid: 2D grid of the same size as bg
+
+No return
+**/
+void bitgrid_to_grid(const bitgrid *bg, int **grid) {
+  for (int i = 0; i < bg->size[0]; i++) {
+    for (int j = 0; j < bg->size[1]; j++) {
+      grid[i][j] = bitgrid_get(bg, i, j);
+    }
+  }
+}
+
+/** Packs a single row or column of an int grid.
+
+Copied parameters:
+ - int *line: the cells of the line
+ - int line_size: the number of cells
+
+Modified parameter:
+ - line_t *value: receives the value bits
+
+Returns:
+ - line_t: the filled bits
+**/
+line_t pack_line(int *line, int line_size, line_t *value) {
+  line_t filled = 0;
+  *value = 0;
+  for (int i = 0; i < line_size; i++) {
+    if (line[i] == 0 || line[i] == 1) {
+      filled |= (line_t)1 << i;
+      *value |= (line_t)line[i] << i;
+    }
+  }
+  return filled;
+}
+
+/** Writes a packed grid as one line of text, row after row: '0' and '1' for
+set cells, '.' for empty ones.
+
+Copied parameter:
+ - const bitgrid *bg: the packed grid
+
+Modified parameter:
+ - char *str: receives rows * cols characters and a '\0'
+
+No return
+**/
+void bitgrid_to_string(const bitgrid *bg, char *str) {
+  for (int i = 0; i < bg->size[0]; i++) {
+    for (int j = 0; j < bg->size[1]; j++) {
+      int value = bitgrid_get(bg, i, j);
+      *str++ = value == -1 ? '.' : '0' + value;
+    }
+  }
+  *str = '\0';
+}
+
+/** Reads a square grid written by bitgrid_to_string: the first word of the
+text must hold size * size cells for an even size.
+
+Copied parameter:
+ - const char *str: the text, leading blanks are skipped
+
+Modified parameter:
+ - bitgrid *bg: receives the grid
+
+Returns:
+ - int: 0 if the text is not a grid
+**/
+int bitgrid_from_string(bitgrid *bg, const char *str) {
+  while (*str == ' ' || *str == '\t') {
+    str++;
+  }
+
+  int cells = (int)strcspn(str, " \t\r\n");
+  int size = 0;
+  while ((size + 1) * (size + 1) <= cells) {
+    size++;
+  }
+  if (size * size != cells || size % 2 || size < 2 || size > MAX_GRID_SIZE) {
+    return 0;
+  }
+
+  int grid_size[2] = {size, size};
+  bitgrid_init(bg, grid_size);
+  for (int c = 0; c < cells; c++) {
+    if (str[c] == '0' || str[c] == '1') {
+      bitgrid_set(bg, c / size, c % size, str[c] - '0');
+    } else if (str[c] != '.') {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,71 @@
+#ifndef BITBOARD_FILE
+#define BITBOARD_FILE
+
+#include <stdint.h>
+
+#define MAX_GRID_SIZE 64
+
+typedef uint64_t line_t;
+
+/* Packed grid: bit j of row_filled[i] tells whether cell (i,j) is set and bit j
+of row_value[i] holds its value. The col_* arrays mirror the same cells in
+column-major order (bit i of col_*[j]). The arrays are sized for the largest
+grid (2 KB) so that a bitgrid can live on the stack and be copied by
+assignment during the search; only the first size[0] rows and size[1] columns
+are meaningful, and only those are cleared by bitgrid_init. */
+typedef struct bitgrid {
+  int size[2];
+  line_t row_filled[MAX_GRID_SIZE];
+  line_t row_value[MAX_GRID_SIZE];
+  line_t col_filled[MAX_GRID_SIZE];
+  line_t col_value[MAX_GRID_SIZE];
+} bitgrid;
+
+void bitgrid_init(bitgrid *bg, int grid_size[2]);
+void bitgrid_from_grid(bitgrid *bg, int **grid, int grid_size[2]);
+void bitgrid_to_grid(const bitgrid *bg, int **grid);
+line_t pack_line(int *line, int line_size, line_t *value);
+void bitgrid_to_string(const bitgrid *bg, char *str);
+int bitgrid_from_string(bitgrid *bg, const char *str);
+
+/* Mask with the line_size lowest bits set */
+static inline line_t line_mask(int line_size) {
+  return line_size >= 64 ? ~(line_t)0 : (((line_t)1 << line_size) - 1);
+}
+
+/* Value of cell (i,j): 0, 1 or -1 when empty */
+static inline int bitgrid_get(const bitgrid *bg, int i, int j) {
+  if (!((bg->row_filled[i] >> j) & 1)) {
+    return -1;
+  }
+  return (int)((bg->row_value[i] >> j) & 1);
+}
+
+/* Sets cell (i,j) to value (0 or 1) in both the row and the column views */
+static inline void bitgrid_set(bitgrid *bg, int i, int j, int value) {
+  line_t row_bit = (line_t)1 << j;
+  line_t col_bit = (line_t)1 << i;
+
+  bg->row_filled[i] |= row_bit;
+  bg->col_filled[j] |= col_bit;
+  if (value) {
+    bg->row_value[i] |= row_bit;
+    bg->col_value[j] |= col_bit;
+  } else {
+    bg->row_value[i] &= ~row_bit;
+    bg->col_value[j] &= ~col_bit;
+  }
+}
+
+/* Empties cell (i,j) */
+static inline void bitgrid_unset(bitgrid *bg, int i, int j) {
+  line_t row_bit = (line_t)1 << j;
+  line_t col_bit = (line_t)1 << i;
+
+  bg->row_filled[i] &= ~row_bit;
+  bg->row_value[i] &= ~row_bit;
+  bg->col_filled[j] &= ~col_bit;
+  bg->col_value[j] &= ~col_bit;
+}
+
+#endif
@@ -0,0 +1,1128 @@
+/**
+ * FILENAME: cdcl.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Conflict-driven clause learning solver. Every cell is a boolean
+ *        variable, but the rules are not turned into clauses: propagators
+ *        check the triples, the balance and the repeated lines on the packed
+ *        rows and columns, and give on demand the cells that forced each
+ *        value. A conflict is analysed back to its first unique implication
+ *        point, the clause learned from it is watched by two of its
+ *        literals, and the search jumps back to the deepest level where that
+ *        clause still forces a value. Cells are chosen by VSIDS activity and
+ *        take their last value again, restarts follow the Luby sequence and
+ *        the learned clauses spanning the most levels are dropped as they
+ *        pile up, by compacting the pool they are allocated from. Unlike the
+ *        depth-first search, a failure found deep in the tree is never
+ *        searched for again. Solutions are counted by adding, for each one
+ *        found, a clause that excludes it and searching on.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int cdcl_solve(bitgrid *bg, long max_conflicts)
+ *        int cdcl_count_solutions(bitgrid *bg, int limit)
+ *
+ **/
+
+#include "cdcl.h"
+#include "arena.h"
+#include "stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CDCL_MAX_VARS (MAX_GRID_SIZE * MAX_GRID_SIZE)
+
+/* Conflicts between two restarts, times the Luby sequence */
+#define RESTART_CONFLICTS 100
+
+/* Learned clauses kept before the first reduction, and the growth of that
+limit at each reduction */
+#define FIRST_REDUCE 2000
+#define REDUCE_GROWTH 300
+
+/* Learned clauses spanning at most that many levels are always kept */
+#define GLUE_LBD 2
+
+/* The learned clauses live in a pool of ints sized for this many clauses of
+this many literals, beyond the variables; reductions compact it, and it
+only grows when a reduction leaves it more than half full */
+#define POOL_CLAUSES FIRST_REDUCE
+#define POOL_CLAUSE_LENGTH 16
+
+#define ACTIVITY_DECAY 0.95
+#define ACTIVITY_LIMIT 1e100
+
+/* Why a variable has its value: a decision (or a clue), a learned clause,
+or one of the rules. The rules keep what is needed to list the cells behind
+the value: the two cells of a triple, the line and the counted value of a
+balance, the two lines of a repetition */
+#define REASON_DECISION 0
+#define REASON_CLAUSE 1
+#define REASON_TRIPLE 2
+#define REASON_BALANCE 3
+#define REASON_UNIQUE 4
+
+#define DIR_ROW 0
+#define DIR_COL 1
+
+/* Literal of cell var holding value: true when it does */
+#define LIT(var, value) (2 * (var) + (value))
+
+/* A learned clause, at some offset of the clause pool. The clauses watching
+a literal form a list linked through them: next[k] is the offset of the next
+clause watching lits[k] */
+typedef struct cdcl_clause {
+  int size;
+  int lbd;
+  int deleted;
+  int next[2];
+  int lits[];
+} cdcl_clause;
+
+#define NO_CLAUSE -1
+
+/* Ints taken in the pool by a clause of len literals */
+#define CLAUSE_WORDS(len) ((int)(sizeof(cdcl_clause) / sizeof(int)) + (len))
+#define POOL_WORDS(vars)                                                      \
+  ((POOL_CLAUSES + (vars)) * CLAUSE_WORDS(POOL_CLAUSE_LENGTH))
+
+typedef struct cdcl_var {
+  signed char value;
+  signed char phase;
+  unsigned char seen;
+  unsigned char reason;
+  int level;
+  int trail_pos;
+  int a;
+  int b;
+  int clause;
+  double activity;
+  int heap_pos;
+} cdcl_var;
+
+/* Variable i * cols + j is cell (i,j). The values are mirrored in a bitgrid,
+with the count of each value per line, for the propagators */
+typedef struct cdcl_solver {
+  int size[2];
+  int vars;
+  bitgrid grid;
+  int count[2][MAX_GRID_SIZE][2];
+  cdcl_var var[CDCL_MAX_VARS];
+  int trail[CDCL_MAX_VARS];
+  int trail_len;
+  int head;
+  int level;
+  int level_start[CDCL_MAX_VARS + 1];
+  int heap[CDCL_MAX_VARS];
+  int heap_len;
+  double bump;
+  int watches[2 * CDCL_MAX_VARS];
+  int *pool;
+  int pool_used;
+  int pool_size;
+  int pool_grown;
+  cdcl_clause **order;
+  int learnt_count;
+  int conflict[CDCL_MAX_VARS];
+  int conflict_len;
+  int learnt[CDCL_MAX_VARS];
+  int reason[CDCL_MAX_VARS];
+  int level_stamp[CDCL_MAX_VARS + 1];
+  int stamp;
+} cdcl_solver;
+
+static inline cdcl_clause *clause_at(const cdcl_solver *s, int ref) {
+  return (cdcl_clause *)(s->pool + ref);
+}
+
+/* Length of the lines of a direction */
+static inline int line_length(const cdcl_solver *s, int d) {
+  return s->size[1 - d];
+}
+
+/* Variable of cell k of a line */
+static inline int cell_var(const cdcl_solver *s, int d, int line, int k) {
+  return d == DIR_ROW ? line * s->size[1] + k : k * s->size[1] + line;
+}
+
+static inline line_t line_filled(const cdcl_solver *s, int d, int line) {
+  return d == DIR_ROW ? s->grid.row_filled[line] : s->grid.col_filled[line];
+}
+
+static inline line_t line_value(const cdcl_solver *s, int d, int line) {
+  return d == DIR_ROW ? s->grid.row_value[line] : s->grid.col_value[line];
+}
+
+/* The literal of an assigned variable that is false */
+static inline int false_lit(const cdcl_solver *s, int v) {
+  return LIT(v, 1 - s->var[v].value);
+}
+
+/* Value of a literal: 1 true, 0 false, -1 unassigned */
+static inline int lit_value(const cdcl_solver *s, int lit) {
+  int value = s->var[lit >> 1].value;
+  return value < 0 ? -1 : value == (lit & 1);
+}
+
+/* Moves a variable of the activity heap up to its place
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int k : its position in the heap
+*/
+static void heap_up(cdcl_solver *s, int k) {
+  int v = s->heap[k];
+
+  while (k > 0) {
+    int parent = (k - 1) / 2;
+    if (s->var[s->heap[parent]].activity >= s->var[v].activity) {
+      break;
+    }
+    s->heap[k] = s->heap[parent];
+    s->var[s->heap[k]].heap_pos = k;
+    k = parent;
+  }
+  s->heap[k] = v;
+  s->var[v].heap_pos = k;
+}
+
+/* Moves a variable of the activity heap down to its place
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int k : its position in the heap
+*/
+static void heap_down(cdcl_solver *s, int k) {
+  int v = s->heap[k];
+
+  for (;;) {
+    int child = 2 * k + 1;
+    if (child >= s->heap_len) {
+      break;
+    }
+    if (child + 1 < s->heap_len && s->var[s->heap[child + 1]].activity >
+                                       s->var[s->heap[child]].activity) {
+      child++;
+    }
+    if (s->var[s->heap[child]].activity <= s->var[v].activity) {
+      break;
+    }
+    s->heap[k] = s->heap[child];
+    s->var[s->heap[k]].heap_pos = k;
+    k = child;
+  }
+  s->heap[k] = v;
+  s->var[v].heap_pos = k;
+}
+
+static void heap_insert(cdcl_solver *s, int v) {
+  if (s->var[v].heap_pos < 0) {
+    s->heap[s->heap_len] = v;
+    heap_up(s, s->heap_len++);
+  }
+}
+
+static int heap_pop(cdcl_solver *s) {
+  int v = s->heap[0];
+
+  s->var[v].heap_pos = -1;
+  if (--s->heap_len > 0) {
+    s->heap[0] = s->heap[s->heap_len];
+    heap_down(s, 0);
+  }
+  return v;
+}
+
+/* Raises the activity of a variable met in a conflict
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int v : the variable
+*/
+static void bump_var(cdcl_solver *s, int v) {
+  if ((s->var[v].activity += s->bump) > ACTIVITY_LIMIT) {
+    for (int u = 0; u < s->vars; u++) {
+      s->var[u].activity /= ACTIVITY_LIMIT;
+    }
+    s->bump /= ACTIVITY_LIMIT;
+  }
+  if (s->var[v].heap_pos >= 0) {
+    heap_up(s, s->var[v].heap_pos);
+  }
+}
+
+/* Gives a literal's variable its value at the current level
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int lit : the literal made true
+-int reason : the REASON_* of the value
+-int a, int b : what the rule needs to list the cells behind the value
+-int clause : the offset of the clause behind the value, for REASON_CLAUSE
+*/
+static void assign(cdcl_solver *s, int lit, int reason, int a, int b,
+                   int clause) {
+  int v = lit >> 1, value = lit & 1;
+  int i = v / s->size[1], j = v % s->size[1];
+  cdcl_var *x = &s->var[v];
+
+  x->value = value;
+  x->level = s->level;
+  x->trail_pos = s->trail_len;
+  x->reason = reason;
+  x->a = a;
+  x->b = b;
+  x->clause = clause;
+  s->trail[s->trail_len++] = lit;
+  bitgrid_set(&s->grid, i, j, value);
+  s->count[DIR_ROW][i][value]++;
+  s->count[DIR_COL][j][value]++;
+}
+
+/* Lists the false literals of the cells behind a value forced by a rule
+Copied parameters :
+-const cdcl_solver *s : the solver
+-int reason, int a, int b : the rule and its data
+-int skip : the forced variable, left out
+-int limit : only cells assigned before this trail position count
+Modified parameter :
+-int *out : receives the literals
+Return : int, the number of literals
+*/
+static int rule_reason(const cdcl_solver *s, int reason, int a, int b,
+                       int skip, int limit, int *out) {
+  int n = 0;
+
+  if (reason == REASON_TRIPLE) {
+    out[n++] = false_lit(s, a);
+    out[n++] = false_lit(s, b);
+    return n;
+  }
+
+  int d = a / MAX_GRID_SIZE, line = a % MAX_GRID_SIZE;
+  int len = line_length(s, d);
+  for (int k = 0; k < len; k++) {
+    int v = cell_var(s, d, line, k);
+    if (v != skip && s->var[v].value >= 0 && s->var[v].trail_pos < limit &&
+        (reason == REASON_UNIQUE || s->var[v].value == b)) {
+      out[n++] = false_lit(s, v);
+    }
+    if (reason == REASON_UNIQUE) {
+      v = cell_var(s, d, b, k);
+      if (v != skip && s->var[v].value >= 0 && s->var[v].trail_pos < limit) {
+        out[n++] = false_lit(s, v);
+      }
+    }
+  }
+  return n;
+}
+
+/* Lists the false literals that forced the value of a variable
+Copied parameters :
+-const cdcl_solver *s : the solver
+-int v : a variable that is not a decision
+Modified parameter :
+-int *out : receives the literals
+Return : int, the number of literals
+*/
+static int reason_literals(const cdcl_solver *s, int v, int *out) {
+  const cdcl_var *x = &s->var[v];
+
+  if (x->reason == REASON_CLAUSE) {
+    const cdcl_clause *c = clause_at(s, x->clause);
+    for (int k = 1; k < c->size; k++) {
+      out[k - 1] = c->lits[k];
+    }
+    return c->size - 1;
+  }
+  return rule_reason(s, x->reason, x->a, x->b, v, x->trail_pos, out);
+}
+
+/* Makes a literal true because of a rule, or records the conflict when it is
+already false
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int lit : the literal
+-int reason, int a, int b : the rule and its data
+Return : int, 0 on a conflict
+*/
+static int imply(cdcl_solver *s, int lit, int reason, int a, int b) {
+  int value = lit_value(s, lit);
+
+  if (value < 0) {
+    assign(s, lit, reason, a, b, NO_CLAUSE);
+    return 1;
+  }
+  if (value == 0) {
+    s->conflict_len = rule_reason(s, reason, a, b, lit >> 1, s->trail_len,
+                                  s->conflict);
+    s->conflict[s->conflict_len++] = lit;
+    return 0;
+  }
+  return 1;
+}
+
+/* Tells whether cell k of a line holds a value
+Copied parameters :
+-const cdcl_solver *s : the solver
+-int d, int line : the line
+-int k : the position, possibly outside the line
+-int x : the value
+Return : int
+*/
+static int line_has(const cdcl_solver *s, int d, int line, int k, int x) {
+  if (k < 0 || k >= line_length(s, d) ||
+      !((line_filled(s, d, line) >> k) & 1)) {
+    return 0;
+  }
+  return (int)((line_value(s, d, line) >> k) & 1) == x;
+}
+
+/* Triples: a pair of equal cells, or two equal cells around an empty one,
+forces the other value next to them
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int d, int line : the line of the new value
+-int pos : its position in the line
+-int v : its variable
+-int x : the value
+Return : int, 0 on a conflict
+*/
+static int propagate_triples(cdcl_solver *s, int d, int line, int pos, int v,
+                             int x) {
+  int len = line_length(s, d);
+
+  for (int side = -1; side <= 1; side += 2) {
+    int near = pos + side, far = pos + 2 * side, back = pos - side;
+    if (line_has(s, d, line, near, x)) {
+      int partner = cell_var(s, d, line, near);
+      if (far >= 0 && far < len &&
+          !imply(s, LIT(cell_var(s, d, line, far), 1 - x), REASON_TRIPLE, v,
+                 partner)) {
+        return 0;
+      }
+      if (back >= 0 && back < len &&
+          !imply(s, LIT(cell_var(s, d, line, back), 1 - x), REASON_TRIPLE, v,
+                 partner)) {
+        return 0;
+      }
+    }
+    if (line_has(s, d, line, far, x) &&
+        !imply(s, LIT(cell_var(s, d, line, near), 1 - x), REASON_TRIPLE, v,
+               cell_var(s, d, line, far))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Balance: once a line holds half of its cells with a value, the others
+take the other value
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int d, int line : the line of the new value
+-int x : the value
+Return : int, 0 on a conflict
+*/
+static int propagate_balance(cdcl_solver *s, int d, int line, int x) {
+  int len = line_length(s, d), half = len / 2;
+  int count = s->count[d][line][x];
+
+  if (count < half) {
+    return 1;
+  }
+  if (count > half) {
+    s->conflict_len = 0;
+    for (int k = 0; s->conflict_len <= half; k++) {
+      if (line_has(s, d, line, k, x)) {
+        s->conflict[s->conflict_len++] = LIT(cell_var(s, d, line, k), 1 - x);
+      }
+    }
+    return 0;
+  }
+
+  line_t empty = line_mask(len) & ~line_filled(s, d, line);
+  for (; empty; empty &= empty - 1) {
+    int k = __builtin_ctzll(empty);
+    if (!imply(s, LIT(cell_var(s, d, line, k), 1 - x), REASON_BALANCE,
+               d * MAX_GRID_SIZE + line, x)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Compares a line with at most two empty cells to a completed one: if they
+agree on every filled cell, the empty cells take the other values, since
+with the balance one matching value would make the lines equal
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int d : the direction of the lines
+-int line : the line with at most two empty cells
+-int full : the completed line
+Return : int, 0 on a conflict
+*/
+static int check_against(cdcl_solver *s, int d, int line, int full) {
+  line_t mask = line_mask(line_length(s, d));
+  line_t filled = line_filled(s, d, line);
+  line_t value = line_value(s, d, full);
+
+  if ((line_value(s, d, line) ^ value) & filled) {
+    return 1;
+  }
+
+  line_t empty = mask & ~filled;
+  if (!empty) {
+    s->conflict_len =
+        rule_reason(s, REASON_UNIQUE, d * MAX_GRID_SIZE + line, full, -1,
+                    s->trail_len, s->conflict);
+    return 0;
+  }
+  for (; empty; empty &= empty - 1) {
+    int k = __builtin_ctzll(empty);
+    int lit = LIT(cell_var(s, d, line, k), 1 - (int)((value >> k) & 1));
+    if (!imply(s, lit, REASON_UNIQUE, d * MAX_GRID_SIZE + line, full)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Repeated lines: once a line has at most two empty cells, it is compared
+with the completed lines, and once it is completed, with the lines that have
+at most two empty cells
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int d, int line : the line of the new value
+Return : int, 0 on a conflict
+*/
+static int propagate_unique(cdcl_solver *s, int d, int line) {
+  int len = line_length(s, d), lines = s->size[d];
+  line_t mask = line_mask(len);
+
+  if (__builtin_popcountll(mask & ~line_filled(s, d, line)) > 2) {
+    return 1;
+  }
+  for (int other = 0; other < lines; other++) {
+    if (other == line) {
+      continue;
+    }
+    line_t filled = line_filled(s, d, line);
+    line_t other_filled = line_filled(s, d, other);
+    if (filled == mask &&
+        __builtin_popcountll(mask & ~other_filled) <= 2) {
+      if (!check_against(s, d, other, line)) {
+        return 0;
+      }
+    } else if (other_filled == mask && !check_against(s, d, line, other)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Runs the rules on the row and the column of a new value
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int v : the variable
+Return : int, 0 on a conflict
+*/
+static int propagate_cell(cdcl_solver *s, int v) {
+  int i = v / s->size[1], j = v % s->size[1], x = s->var[v].value;
+
+  return propagate_triples(s, DIR_ROW, i, j, v, x) &&
+         propagate_balance(s, DIR_ROW, i, x) &&
+         propagate_unique(s, DIR_ROW, i) &&
+         propagate_triples(s, DIR_COL, j, i, v, x) &&
+         propagate_balance(s, DIR_COL, j, x) &&
+         propagate_unique(s, DIR_COL, j);
+}
+
+/* Adds a clause to the watches of its first two literals
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int ref : the offset of the clause
+*/
+static void watch(cdcl_solver *s, int ref) {
+  cdcl_clause *c = clause_at(s, ref);
+
+  for (int k = 0; k < 2; k++) {
+    c->next[k] = s->watches[c->lits[k]];
+    s->watches[c->lits[k]] = ref;
+  }
+}
+
+/* Visits the clauses watching a literal that just became false: each one
+watches another literal that is not false, or forces its other watched
+literal, or is the conflict
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int lit : the false literal
+Return : int, 0 on a conflict
+*/
+static int propagate_clauses(cdcl_solver *s, int lit) {
+  int *link = &s->watches[lit];
+
+  while (*link != NO_CLAUSE) {
+    int ref = *link;
+    cdcl_clause *c = clause_at(s, ref);
+    if (c->lits[0] == lit) {
+      c->lits[0] = c->lits[1];
+      c->lits[1] = lit;
+      int next = c->next[0];
+      c->next[0] = c->next[1];
+      c->next[1] = next;
+    }
+    if (lit_value(s, c->lits[0]) == 1) {
+      link = &c->next[1];
+      continue;
+    }
+
+    int moved = 0;
+    for (int m = 2; m < c->size; m++) {
+      if (lit_value(s, c->lits[m]) != 0) {
+        c->lits[1] = c->lits[m];
+        c->lits[m] = lit;
+        *link = c->next[1];
+        c->next[1] = s->watches[c->lits[1]];
+        s->watches[c->lits[1]] = ref;
+        moved = 1;
+        break;
+      }
+    }
+    if (moved) {
+      continue;
+    }
+
+    link = &c->next[1];
+    if (lit_value(s, c->lits[0]) == 0) {
+      for (int m = 0; m < c->size; m++) {
+        s->conflict[m] = c->lits[m];
+      }
+      s->conflict_len = c->size;
+      return 0;
+    }
+    assign(s, c->lits[0], REASON_CLAUSE, 0, 0, ref);
+  }
+  return 1;
+}
+
+/* Propagates every value of the trail not propagated yet
+Modified parameter :
+-cdcl_solver *s : the solver
+Return : int, 0 on a conflict, left in s->conflict
+*/
+static int propagate(cdcl_solver *s) {
+  while (s->head < s->trail_len) {
+    int lit = s->trail[s->head++];
+    if (!propagate_clauses(s, lit ^ 1) || !propagate_cell(s, lit >> 1)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Tells whether a literal of a learned clause is implied by the others
+Modified parameter :
+-cdcl_solver *s : the solver, whose seen flags mark the clause
+Copied parameter :
+-int v : the variable of the literal
+Return : int
+*/
+static int redundant(cdcl_solver *s, int v) {
+  if (s->var[v].reason == REASON_DECISION) {
+    return 0;
+  }
+
+  int n = reason_literals(s, v, s->reason);
+  for (int k = 0; k < n; k++) {
+    const cdcl_var *x = &s->var[s->reason[k] >> 1];
+    if (!x->seen && x->level > 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Learns a clause from the conflict: the reasons of the current level are
+resolved until one literal of that level is left, the first unique
+implication point, then the literals implied by the others are removed
+Modified parameters :
+-cdcl_solver *s : the solver, the clause is left in s->learnt
+-int *backjump : receives the level to jump back to
+-int *lbd : receives the number of levels of the clause
+Return : int, the size of the clause, whose first literal is the one it
+forces after the jump
+*/
+static int analyze(cdcl_solver *s, int *backjump, int *lbd) {
+  int *learnt = s->learnt;
+  const int *lits = s->conflict;
+  int n = s->conflict_len, len = 1, path = 0, index = s->trail_len - 1, p;
+
+  for (;;) {
+    for (int k = 0; k < n; k++) {
+      int v = lits[k] >> 1;
+      cdcl_var *x = &s->var[v];
+      if (x->seen || x->level == 0) {
+        continue;
+      }
+      x->seen = 1;
+      bump_var(s, v);
+      if (x->level == s->level) {
+        path++;
+      } else {
+        learnt[len++] = lits[k];
+      }
+    }
+
+    do {
+      p = s->trail[index--];
+    } while (!s->var[p >> 1].seen);
+    s->var[p >> 1].seen = 0;
+    if (--path == 0) {
+      break;
+    }
+    n = reason_literals(s, p >> 1, s->reason);
+    lits = s->reason;
+  }
+  learnt[0] = p ^ 1;
+
+  /* Removed literals are flipped to negative until the seen flags are
+  cleared */
+  for (int k = 1; k < len; k++) {
+    if (redundant(s, learnt[k] >> 1)) {
+      learnt[k] = -1 - learnt[k];
+    }
+  }
+  int kept = 1;
+  for (int k = 1; k < len; k++) {
+    int lit = learnt[k] < 0 ? -1 - learnt[k] : learnt[k];
+    s->var[lit >> 1].seen = 0;
+    if (learnt[k] >= 0) {
+      learnt[kept++] = lit;
+    }
+  }
+  len = kept;
+
+  *backjump = 0;
+  for (int k = 1; k < len; k++) {
+    if (s->var[learnt[k] >> 1].level > *backjump) {
+      *backjump = s->var[learnt[k] >> 1].level;
+      int swap = learnt[1];
+      learnt[1] = learnt[k];
+      learnt[k] = swap;
+    }
+  }
+
+  s->stamp++;
+  *lbd = 0;
+  for (int k = 0; k < len; k++) {
+    int level = s->var[learnt[k] >> 1].level;
+    if (s->level_stamp[level] != s->stamp) {
+      s->level_stamp[level] = s->stamp;
+      (*lbd)++;
+    }
+  }
+  return len;
+}
+
+/* Undoes every level above a level
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameter :
+-int level : the level to go back to
+*/
+static void backtrack(cdcl_solver *s, int level) {
+  if (s->level <= level) {
+    return;
+  }
+
+  int start = s->level_start[level + 1];
+  for (int k = s->trail_len - 1; k >= start; k--) {
+    int v = s->trail[k] >> 1;
+    int i = v / s->size[1], j = v % s->size[1];
+    cdcl_var *x = &s->var[v];
+    s->count[DIR_ROW][i][x->value]--;
+    s->count[DIR_COL][j][x->value]--;
+    bitgrid_unset(&s->grid, i, j);
+    x->phase = x->value;
+    x->value = -1;
+    heap_insert(s, v);
+  }
+  s->trail_len = start;
+  s->head = start;
+  s->level = level;
+}
+
+static int compare_clauses(const void *a, const void *b) {
+  const cdcl_clause *x = *(cdcl_clause *const *)a;
+  const cdcl_clause *y = *(cdcl_clause *const *)b;
+
+  if (x->lbd != y->lbd) {
+    return x->lbd - y->lbd;
+  }
+  return x->size - y->size;
+}
+
+/* Doubles the clause pool, for when a reduction leaves it more than half
+full; the offsets of the clauses stay the same
+Modified parameter :
+-cdcl_solver *s : the solver
+Return : int, 0 if the memory could not be allocated
+*/
+static int grow_pool(cdcl_solver *s) {
+  int size = 2 * s->pool_size;
+  int *pool = malloc(size * sizeof(int));
+  cdcl_clause **order =
+      malloc(size / CLAUSE_WORDS(2) * sizeof(cdcl_clause *));
+
+  if (!pool || !order) {
+    free(pool);
+    free(order);
+    return 0;
+  }
+  memcpy(pool, s->pool, s->pool_used * sizeof(int));
+  if (s->pool_grown) {
+    free(s->pool);
+    free(s->order);
+  }
+  s->pool = pool;
+  s->order = order;
+  s->pool_size = size;
+  s->pool_grown = 1;
+  return 1;
+}
+
+/* Drops half of the learned clauses, those spanning the most levels first,
+except the ones forcing a value of the trail and the glue clauses, then
+compacts the pool and links the watches again
+Modified parameter :
+-cdcl_solver *s : the solver
+Return : int, 0 if the pool had to grow and could not
+*/
+static int reduce_learnts(cdcl_solver *s) {
+  int count = 0;
+  for (int ref = 0; ref < s->pool_used;
+       ref += CLAUSE_WORDS(clause_at(s, ref)->size)) {
+    s->order[count++] = clause_at(s, ref);
+  }
+  qsort(s->order, count, sizeof(cdcl_clause *), compare_clauses);
+  for (int k = 0; k < count; k++) {
+    s->order[k]->deleted = k >= count / 2 && s->order[k]->lbd > GLUE_LBD;
+  }
+
+  /* Clauses only move towards the start, so the next one is read before
+  anything is written over it */
+  int used = 0;
+  s->learnt_count = 0;
+  for (int ref = 0; ref < s->pool_used;) {
+    cdcl_clause *c = clause_at(s, ref);
+    int words = CLAUSE_WORDS(c->size);
+    cdcl_var *x = &s->var[c->lits[0] >> 1];
+    int locked =
+        x->value >= 0 && x->reason == REASON_CLAUSE && x->clause == ref;
+    if (!c->deleted || locked) {
+      if (locked) {
+        x->clause = used;
+      }
+      memmove(s->pool + used, c, words * sizeof(int));
+      used += words;
+      s->learnt_count++;
+    }
+    ref += words;
+  }
+  s->pool_used = used;
+
+  for (int lit = 0; lit < 2 * s->vars; lit++) {
+    s->watches[lit] = NO_CLAUSE;
+  }
+  for (int ref = 0; ref < s->pool_used;
+       ref += CLAUSE_WORDS(clause_at(s, ref)->size)) {
+    watch(s, ref);
+  }
+  return s->pool_size - s->pool_used >= s->pool_size / 2 || grow_pool(s);
+}
+
+/* Keeps the clause of the last analysis and makes its first literal true,
+after the jump back. A full pool is reduced first
+Modified parameter :
+-cdcl_solver *s : the solver
+Copied parameters :
+-int len : the size of the clause
+-int lbd : its number of levels
+Return : int, 0 if the pool had to grow and could not
+*/
+static int learn(cdcl_solver *s, int len, int lbd) {
+  if (len == 1) {
+    assign(s, s->learnt[0], REASON_DECISION, 0, 0, NO_CLAUSE);
+    return 1;
+  }
+  if (s->pool_size - s->pool_used < CLAUSE_WORDS(len) && !reduce_learnts(s)) {
+    return 0;
+  }
+
+  int ref = s->pool_used;
+  cdcl_clause *c = clause_at(s, ref);
+  s->pool_used += CLAUSE_WORDS(len);
+  c->size = len;
+  c->lbd = lbd;
+  c->deleted = 0;
+  for (int k = 0; k < len; k++) {
+    c->lits[k] = s->learnt[k];
+  }
+  watch(s, ref);
+  s->learnt_count++;
+  assign(s, c->lits[0], REASON_CLAUSE, 0, 0, ref);
+  return 1;
+}
+
+/* Chooses the next decision: the unassigned variable of highest activity,
+with its last value, or the value its row and column need the most
+Modified parameter :
+-cdcl_solver *s : the solver
+Return : int, 0 if every variable is assigned
+*/
+static int decide(cdcl_solver *s) {
+  int v;
+
+  do {
+    if (!s->heap_len) {
+      return 0;
+    }
+    v = heap_pop(s);
+  } while (s->var[v].value >= 0);
+
+  int value = s->var[v].phase;
+  if (value < 0) {
+    int i = v / s->size[1], j = v % s->size[1];
+    int need[2];
+    for (int x = 0; x < 2; x++) {
+      need[x] = s->size[1] / 2 - s->count[DIR_ROW][i][x] + s->size[0] / 2 -
+                s->count[DIR_COL][j][x];
+    }
+    value = need[1] > need[0];
+  }
+
+  s->level++;
+  s->level_start[s->level] = s->trail_len;
+  STATS_INC(nodes);
+  STATS_MAX(max_depth, s->level);
+  assign(s, LIT(v, value), REASON_DECISION, 0, 0, NO_CLAUSE);
+  return 1;
+}
+
+/* Excludes the solution on the trail with a clause of the negated
+decisions, since the other values follow from them, and jumps back to where
+that clause forces the last decision to change. The clause spans no level,
+so it is never dropped
+Modified parameter :
+-cdcl_solver *s : the solver, with every variable assigned
+Return : int, 0 if the solution took no decision, so that it is the only
+one, -1 if the clause pool had to grow and could not
+*/
+static int block_solution(cdcl_solver *s) {
+  int len = 0;
+
+  for (int level = s->level; level > 0; level--) {
+    s->learnt[len++] = s->trail[s->level_start[level]] ^ 1;
+  }
+  if (!len) {
+    return 0;
+  }
+  backtrack(s, s->level - 1);
+  return learn(s, len, 0) ? 1 : -1;
+}
+
+/* Term k of the Luby sequence, 1 1 2 1 1 2 4 1 1 2 ...
+Copied parameter :
+-long k : the index, from 0
+Return : long
+*/
+static long luby(long k) {
+  long size = 1;
+  int power = 0;
+
+  while (size < k + 1) {
+    power++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != k) {
+    size = (size - 1) / 2;
+    power--;
+    k %= size;
+  }
+  return 1L << power;
+}
+
+/* Frees the clause pool of a solver if it grew out of the scratch arena,
+where the solver and its first pool live
+Modified parameter :
+-cdcl_solver *s : the solver
+*/
+static void free_solver(cdcl_solver *s) {
+  if (s->pool_grown) {
+    free(s->pool);
+    free(s->order);
+  }
+}
+
+/* Searches the solutions of a packed grid, up to a limit
+Modified parameter :
+-bitgrid *bg : the grid, replaced by the first solution found
+Copied parameters :
+-long max_conflicts : the number of conflicts after which the search gives
+up, -1 for no limit
+-int limit : the number of solutions after which the search stops
+Return : int, the number of solutions found, or -1 if the search gave up or
+its memory could not be allocated
+*/
+static int cdcl_search(bitgrid *bg, long max_conflicts, int limit) {
+  int pool_size = POOL_WORDS(bg->size[0] * bg->size[1]);
+  int order_size = pool_size / CLAUSE_WORDS(2);
+  arena local;
+  size_t mark;
+  arena *scratch = arena_scratch(
+      &local,
+      sizeof(cdcl_solver) + pool_size * sizeof(int) +
+          order_size * sizeof(cdcl_clause *) + 3 * ARENA_ALIGN,
+      &mark);
+  if (!scratch) {
+    return -1;
+  }
+  cdcl_solver *s = arena_alloc(scratch, sizeof(cdcl_solver));
+  int found = 0, result;
+  STATS_START_SEARCH(timer);
+
+  memset(s, 0, sizeof(cdcl_solver));
+  s->size[0] = bg->size[0];
+  s->size[1] = bg->size[1];
+  s->vars = s->size[0] * s->size[1];
+  s->bump = 1;
+  s->pool = arena_alloc(scratch, pool_size * sizeof(int));
+  s->pool_size = pool_size;
+  s->order = arena_alloc(scratch, order_size * sizeof(cdcl_clause *));
+  for (int lit = 0; lit < 2 * s->vars; lit++) {
+    s->watches[lit] = NO_CLAUSE;
+  }
+  bitgrid_init(&s->grid, s->size);
+  for (int v = 0; v < s->vars; v++) {
+    s->var[v].value = -1;
+    s->var[v].phase = -1;
+    s->var[v].heap_pos = -1;
+    heap_insert(s, v);
+  }
+  for (int i = 0; i < s->size[0]; i++) {
+    for (int j = 0; j < s->size[1]; j++) {
+      int value = bitgrid_get(bg, i, j);
+      if (value >= 0 && s->var[i * s->size[1] + j].value < 0) {
+        assign(s, LIT(i * s->size[1] + j, value), REASON_DECISION, 0, 0,
+               NO_CLAUSE);
+      }
+    }
+  }
+
+  long conflicts = 0, since_restart = 0, restarts = 0;
+  long restart_limit = RESTART_CONFLICTS * luby(0);
+  int max_learnts = FIRST_REDUCE;
+  for (;;) {
+    if (!propagate(s)) {
+      STATS_INC(backtracks);
+      if (s->level == 0) {
+        result = found;
+        break;
+      }
+      conflicts++;
+      since_restart++;
+
+      int backjump, lbd;
+      int len = analyze(s, &backjump, &lbd);
+      backtrack(s, backjump);
+      if (!learn(s, len, lbd)) {
+        result = -1;
+        break;
+      }
+      s->bump /= ACTIVITY_DECAY;
+
+      if (max_conflicts >= 0 && conflicts >= max_conflicts) {
+        result = -1;
+        break;
+      }
+      continue;
+    }
+
+    if (since_restart >= restart_limit) {
+      backtrack(s, 0);
+      since_restart = 0;
+      restart_limit = RESTART_CONFLICTS * luby(++restarts);
+    }
+    if (s->learnt_count >= max_learnts + s->trail_len) {
+      if (!reduce_learnts(s)) {
+        result = -1;
+        break;
+      }
+      max_learnts += REDUCE_GROWTH;
+    }
+    if (!decide(s)) {
+      if (++found == 1) {
+        *bg = s->grid;
+      }
+      int blocked = found < limit ? block_solution(s) : 0;
+      if (blocked > 0) {
+        continue;
+      }
+      result = blocked < 0 ? -1 : found;
+      break;
+    }
+  }
+
+  free_solver(s);
+  arena_scratch_done(scratch, &local, mark);
+  STATS_STOP_SEARCH(timer);
+  return result;
+}
+
+/** Solves a packed grid by conflict-driven clause learning. The search is
+complete: without a limit, it finds a solution or proves there is none.
+
+Copied parameter:
+ - long max_conflicts: the number of conflicts after which the search gives
+   up, -1 for no limit
+
+Modified parameter:
+ - bitgrid *bg: the grid, replaced by a solution when one is found
+
+Returns:
+ - int: 1 if a solution was found, 0 if there is none, -1 if the search gave
+   up or its memory could not be allocated
+**/
+int cdcl_solve(bitgrid *bg, long max_conflicts) {
+  return cdcl_search(bg, max_conflicts, 1);
+}
+
+/** Counts the solutions of a packed grid by conflict-driven clause learning,
+up to a limit: cdcl_count_solutions(bg, 2) tells whether a grid has a unique
+solution without the depth-first search.
+
+Copied parameter:
+ - int limit: the number of solutions after which the search stops
+
+Modified parameter:
+ - bitgrid *bg: the grid, replaced by the first solution found
+
+Returns:
+ - int: the number of solutions, at most limit, or -1 if the memory of the
+   search could not be allocated
+**/
+int cdcl_count_solutions(bitgrid *bg, int limit) {
+  return cdcl_search(bg, -1, limit);
+}
@@ -0,0 +1,9 @@
+#ifndef CDCL_FILE
+#define CDCL_FILE
+
+#include "bitboard.h"
+
+int cdcl_solve(bitgrid *bg, long max_conflicts);
+int cdcl_count_solutions(bitgrid *bg, int limit);
+
+#endif
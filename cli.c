@@ -0,0 +1,390 @@
+/**
+ * FILENAME: cli.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Command-line modes of the program, used instead of the interactive
+ *        menu when arguments are given.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int run_cli(int argc, char **argv)
+ *
+ **/
+
+#include "cli.h"
+#include "backtracking.h"
+#include "bank.h"
+#include "batch.h"
+#include "bitboard.h"
+#include "cdcl.h"
+#include "difficulty.h"
+#include "game.h"
+#include "generator.h"
+#include "parallel.h"
+#include "rng.h"
+#include "rules.h"
+#include "service.h"
+#include "stats.h"
+#include "stream.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Prints the command-line usage
+Copied parameter :
+-const char *program : name of the executable
+*/
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "Without options, starts the interactive game.\n\n"
+          "  --generate N   generate N unique puzzles, one per line:\n"
+          "                 \"<puzzle> <solution>\" ('0', '1', '.' per cell)\n"
+          "  --size S       size of the grids (even, default 12)\n"
+          "  --threads T    number of worker threads (default 1)\n"
+          "  --out FILE     output file (default: standard output)\n"
+          "  --bank FILE    store the puzzles in a binary puzzle bank\n"
+          "                 instead of writing text\n"
+          "  --play FILE    start the interactive game with the puzzles of\n"
+          "                 a bank\n"
+          "  --puzzle ID    print the puzzle of an ID (such as\n"
+          "                 12x12-00000000075bcd15, shown by the game) and\n"
+          "                 its solution, like --generate\n"
+          "  --solve GRID   solve one grid ('0', '1', '.' per cell, row after\n"
+          "                 row) with --threads workers sharing its search\n"
+          "                 tree, and print its solution followed by\n"
+          "                 \"unique\" or \"several\"\n"
+          "  --solve-stream solve the puzzles read on standard input, one\n"
+          "                 per line ('0', '1', '.' per cell), and write\n"
+          "                 their solutions in the same order (\"invalid\"\n"
+          "                 or \"unsolvable\" when there is none), using\n"
+          "                 --threads solver workers\n"
+          "  --serve SOCKET serve puzzles on a Unix domain socket, one\n"
+          "                 request per line: \"PUZZLE <size> [tier]\",\n"
+          "                 \"SOLVE <grid>\", \"VALIDATE <grid>\",\n"
+          "                 \"HINT <grid>\", \"STATS\" or \"QUIT\"; puzzles of\n"
+          "                 --size, the only size served, are made ahead of\n"
+          "                 time by --threads producers\n"
+          "  --pool N       puzzles kept ready per size and tier when\n"
+          "                 serving (default 16)\n"
+          "  --solver NAME  search used to solve grids with --solve,\n"
+          "                 --solve-stream and --serve: dfs (default) or\n"
+          "                 cdcl, the clause learning solver, for large or\n"
+          "                 hard grids (on one thread)\n"
+          "  --seed X       seed of the random generators, up to 2^64 - 1,\n"
+          "                 in decimal or in hexadecimal with 0x\n"
+          "                 (default: random)\n"
+          "  --minimal      generate minimal puzzles, where every clue is\n"
+          "                 needed (slow above 16x16; not with --bank, since\n"
+          "                 they are not the puzzles of their IDs)\n"
+          "  --rate         append the difficulty tier and score of each\n"
+          "                 puzzle: \"<puzzle> <solution> <tier> <score>\"\n"
+          "  --stats        print solver statistics on standard error\n"
+          "                 (needs a build with \"make STATS=1\")\n",
+          program);
+}
+
+/* Reads the integer value of an option
+Copied parameters :
+-int argc, char **argv : the arguments
+-int *idx : index of the option, moved to its value
+-long min, long max : accepted range
+Modified parameter :
+-long *value : receives the value
+Return : int, 0 if the value is missing or invalid
+*/
+static int read_number(int argc, char **argv, int *idx, long min, long max,
+                       long *value) {
+  if (*idx + 1 >= argc) {
+    fprintf(stderr, "Missing value for %s.\n", argv[*idx]);
+    return 0;
+  }
+
+  char *end;
+  errno = 0;
+  *value = strtol(argv[++*idx], &end, 10);
+  if (errno == ERANGE || end == argv[*idx] || *end != '\0' || *value < min ||
+      *value > max) {
+    fprintf(stderr, "Invalid value for %s: %s\n", argv[*idx - 1], argv[*idx]);
+    return 0;
+  }
+  return 1;
+}
+
+/* Reads a 64-bit seed, in decimal, or in hexadecimal with 0x as in puzzle IDs
+Copied parameters :
+-int argc, char **argv : the arguments
+-int *idx : index of the option, moved to its value
+Modified parameter :
+-uint64_t *seed : receives the seed
+Return : int, 0 if the seed is missing, invalid or above 2^64 - 1
+*/
+static int read_seed(int argc, char **argv, int *idx, uint64_t *seed) {
+  if (*idx + 1 >= argc) {
+    fprintf(stderr, "Missing value for %s.\n", argv[*idx]);
+    return 0;
+  }
+
+  const char *text = argv[++*idx];
+  char *end;
+  errno = 0;
+  int base = text[0] == '0' && (text[1] == 'x' || text[1] == 'X') ? 16 : 10;
+  unsigned long long value = strtoull(text, &end, base);
+  /* strtoull takes a minus sign and negates the value: refuse it */
+  if (errno == ERANGE || end == text || *end != '\0' ||
+      strchr(text, '-')) {
+    fprintf(stderr, "Invalid value for %s: %s\n", argv[*idx - 1], text);
+    return 0;
+  }
+  *seed = (uint64_t)value;
+  return 1;
+}
+
+/* Starts the interactive game with the puzzles of a bank
+Copied parameter :
+-const char *path : the bank file
+Return : int, the exit status of the program
+*/
+static int play_bank(const char *path) {
+  puzzle_bank bank;
+
+  if (!bank_open(&bank, path)) {
+    fprintf(stderr, "%s is not a readable puzzle bank.\n", path);
+    return 1;
+  }
+
+  rng_seed(rng_random_seed());
+  set_game_bank(&bank);
+  menu();
+  set_game_bank(NULL);
+  bank_close(&bank);
+  return 0;
+}
+
+/* Prints the puzzle of an ID and its solution on one line
+Copied parameters :
+-const char *id : the puzzle ID
+-int rate : whether to append the difficulty tier and score
+Return : int, the exit status of the program
+*/
+static int print_puzzle(const char *id, int rate) {
+  int grid_size[2];
+  uint64_t seed;
+  bitgrid solution, puzzle;
+  char line[2 * MAX_GRID_SIZE * MAX_GRID_SIZE + 2];
+
+  if (!parse_puzzle_id(id, grid_size, &seed)) {
+    fprintf(stderr, "Invalid puzzle ID: %s\n", id);
+    return 1;
+  }
+  if (!generate_puzzle(seed, grid_size, &solution, &puzzle)) {
+    fprintf(stderr, "No puzzle of size %dx%d.\n", grid_size[0],
+            grid_size[1]);
+    return 1;
+  }
+
+  int cells = grid_size[0] * grid_size[1];
+  bitgrid_to_string(&puzzle, line);
+  line[cells] = ' ';
+  bitgrid_to_string(&solution, line + cells + 1);
+  fputs(line, stdout);
+
+  difficulty_report report;
+  if (rate && rate_puzzle(&puzzle, &report)) {
+    printf(" %s %d", tier_name(report.tier), report.score);
+  }
+  printf("\n");
+  return 0;
+}
+
+/* Solves one grid, splitting its search tree between threads, and tells
+whether its solution is unique. The CDCL backend runs on one thread and
+counts the solutions itself
+Copied parameters :
+-const char *text : the grid, '0', '1' or '.' per cell
+-int threads : the number of worker threads
+-int backend : BACKEND_DFS or BACKEND_CDCL
+Return : int, the exit status of the program
+*/
+static int solve_one(const char *text, int threads, int backend) {
+  bitgrid puzzle, bg;
+  char line[MAX_GRID_SIZE * MAX_GRID_SIZE + 1];
+
+  if (!bitgrid_from_string(&puzzle, text)) {
+    printf("invalid\n");
+    return 1;
+  }
+  bg = puzzle;
+  int count;
+  if (backend == BACKEND_CDCL) {
+    count = cdcl_count_solutions(&bg, 2);
+  } else {
+    count = bitgrid_solve_parallel(&bg, threads);
+  }
+  if (count <= 0 || !bitgrid_is_solved(&bg)) {
+    printf("unsolvable\n");
+    return 1;
+  }
+
+  bitgrid_to_string(&bg, line);
+  if (backend != BACKEND_CDCL) {
+    count = bitgrid_count_solutions_parallel(&puzzle, 2, threads);
+  }
+  printf("%s %s\n", line, count == 1 ? "unique" : "several");
+  return 0;
+}
+
+/* Runs the mode selected by the command-line arguments
+Copied parameters :
+-int argc, char **argv : the arguments of main
+Return : int, the exit status of the program
+*/
+int run_cli(int argc, char **argv) {
+  long count = -1, size = 12, threads = 1, capacity = 16;
+  int show_stats = 0, rate = 0, stream = 0, minimal = 0;
+  uint64_t seed = rng_random_seed();
+  const char *out_path = NULL, *bank_path = NULL, *play_path = NULL;
+  const char *puzzle_id = NULL, *socket_path = NULL, *solve_grid = NULL;
+  int backend = BACKEND_DFS;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--generate")) {
+      if (!read_number(argc, argv, &i, 1, 2000000000L, &count)) {
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--size")) {
+      if (!read_number(argc, argv, &i, 2, MAX_GRID_SIZE, &size)) {
+        return 1;
+      }
+      if (size % 2) {
+        fprintf(stderr, "The size must be even.\n");
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--threads")) {
+      if (!read_number(argc, argv, &i, 1, 1024, &threads)) {
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--seed")) {
+      if (!read_seed(argc, argv, &i, &seed)) {
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--pool")) {
+      if (!read_number(argc, argv, &i, 1, 4096, &capacity)) {
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--solve") && i + 1 < argc) {
+      solve_grid = argv[++i];
+    } else if (!strcmp(argv[i], "--solve-stream")) {
+      stream = 1;
+    } else if (!strcmp(argv[i], "--rate")) {
+      rate = 1;
+    } else if (!strcmp(argv[i], "--minimal")) {
+      minimal = 1;
+    } else if (!strcmp(argv[i], "--stats")) {
+      show_stats = 1;
+    } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (!strcmp(argv[i], "--bank") && i + 1 < argc) {
+      bank_path = argv[++i];
+    } else if (!strcmp(argv[i], "--play") && i + 1 < argc) {
+      play_path = argv[++i];
+    } else if (!strcmp(argv[i], "--puzzle") && i + 1 < argc) {
+      puzzle_id = argv[++i];
+    } else if (!strcmp(argv[i], "--serve") && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (!strcmp(argv[i], "--solver") && i + 1 < argc) {
+      i++;
+      if (!strcmp(argv[i], "cdcl")) {
+        backend = BACKEND_CDCL;
+      } else if (!strcmp(argv[i], "dfs")) {
+        backend = BACKEND_DFS;
+      } else {
+        fprintf(stderr, "Unknown solver: %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  set_solver_backend(backend);
+
+  if (play_path) {
+    return play_bank(play_path);
+  }
+  if (puzzle_id) {
+    return print_puzzle(puzzle_id, rate);
+  }
+  if (socket_path) {
+    int warm_size = size;
+    return run_service(socket_path, &warm_size, 1, capacity, threads, seed);
+  }
+  if (solve_grid) {
+    stats_reset();
+    int status = solve_one(solve_grid, threads, backend);
+    if (show_stats) {
+      solver_stats stats;
+      stats_total(&stats);
+      stats_print(&stats, stderr);
+    }
+    return status;
+  }
+  if (stream) {
+    long total;
+    stats_reset();
+    long solved = solve_stream(stdin, stdout, threads, &total);
+    if (show_stats) {
+      solver_stats stats;
+      stats_total(&stats);
+      stats_print(&stats, stderr);
+    }
+    return solved == total ? 0 : 1;
+  }
+  if (count < 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  if (minimal && bank_path) {
+    fprintf(stderr, "--minimal cannot be used with --bank.\n");
+    return 1;
+  }
+
+  int grid_size[2] = {size, size};
+  bank_writer bank;
+  if (bank_path && !bank_create(&bank, bank_path, grid_size, count)) {
+    perror(bank_path);
+    return 1;
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    perror(out_path);
+    return 1;
+  }
+
+  stats_reset();
+  int written = generate_batch(count, grid_size, threads, seed, rate, minimal,
+                               out, bank_path ? &bank : NULL);
+
+  if (out != stdout) {
+    fclose(out);
+  } else {
+    fflush(out);
+  }
+  if (bank_path && !bank_finish(&bank)) {
+    perror(bank_path);
+    return 1;
+  }
+
+  if (show_stats) {
+    solver_stats stats;
+    stats_total(&stats);
+    stats_print(&stats, stderr);
+  }
+  return written == count ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#ifndef CLI_FILE
+#define CLI_FILE
+
+int run_cli(int argc, char **argv);
+
+#endif
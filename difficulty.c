@@ -0,0 +1,412 @@
+/**
+ * FILENAME: difficulty.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Difficulty rating of puzzles. The rater solves a puzzle like a
+ *        person would: it always uses the easiest technique that still fills
+ *        a cell, and only moves to a harder one when every easier one is
+ *        stuck. The techniques needed, and how often, give a score and a
+ *        tier. The same steps, recorded cell by cell, make the solve trace
+ *        that the game uses for hints and autoplay.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int rate_puzzle(const bitgrid *puzzle, difficulty_report *report)
+ *        int rate_grid(int **grid, int grid_size[2],
+ *                      difficulty_report *report)
+ *        int trace_puzzle(const bitgrid *puzzle, const bitgrid *solution,
+ *                         solve_trace *trace)
+ *        int ease_puzzle(bitgrid *puzzle, const bitgrid *solution, int tier)
+ *        const char *technique_name(int technique)
+ *        const char *tier_name(int tier)
+ *
+ **/
+
+#include "difficulty.h"
+#include "propagation.h"
+#include "solver.h"
+
+#include <string.h>
+
+/* Rules allowed at each deduction technique: every technique may also use
+the easier ones */
+static const int technique_rules[TECH_LINE + 1] = {
+    RULE_PAIR | RULE_GAP,
+    RULE_PAIR | RULE_GAP | RULE_QUOTA,
+    RULE_PAIR | RULE_GAP | RULE_QUOTA | RULE_DUPLICATE,
+    RULES_ALL,
+};
+
+/* Points of one step of each technique (one node for the search) */
+static const int technique_weight[TECHNIQUE_COUNT] = {1, 1, 3, 6, 15, 40};
+
+static const char *technique_names[TECHNIQUE_COUNT] = {
+    "pairs and gaps", "quota", "duplicate line", "line analysis", "probing",
+    "search"};
+
+/* Hardest technique allowed in each tier */
+static const int tier_hardest[TIER_COUNT] = {TECH_QUOTA, TECH_DUPLICATE,
+                                             TECH_LINE, TECH_SEARCH};
+
+static const char *tier_names[TIER_COUNT] = {"easy", "medium", "hard",
+                                             "expert"};
+
+/* Branches on the cells the techniques cannot fill, recording the number of
+nodes and the deepest branching. The nodes only propagate: probing at every
+node would cost more than the guesses it saves
+Modified parameters :
+-solver_state *s : the search state
+-difficulty_report *report : receives the search counters
+Copied parameter :
+-int depth : number of branchings above this node
+Return : int, whether a solution was found
+*/
+static int rate_search(solver_state *s, difficulty_report *report,
+                       int depth) {
+  report->search_nodes++;
+  if (depth > report->search_depth) {
+    report->search_depth = depth;
+  }
+
+  if (!propagate(s, RULES_ALL)) {
+    return 0;
+  }
+
+  int next[2];
+  if (!solver_next_cell(s, next)) {
+    return 1;
+  }
+
+  for (int val = 0; val < 2; val++) {
+    int mark = s->trail_len;
+    if (solver_assign(s, next[0], next[1], val) &&
+        rate_search(s, report, depth + 1)) {
+      return 1;
+    }
+    solver_undo(s, mark);
+  }
+  return 0;
+}
+
+/* Assigns the cells a technique harder than pairs and gaps forces on its own
+first line where it forces any. The cells these force in turn are left to the
+next steps
+Modified parameter :
+-solver_state *s : the search state, where the easier techniques are stuck
+Copied parameter :
+-int t : TECH_QUOTA, TECH_DUPLICATE or TECH_LINE
+Return : int, 1 if cells were filled, 0 if none, -1 on a contradiction
+*/
+static int line_step(solver_state *s, int t) {
+  bitgrid *bg = &s->grid;
+
+  for (int is_row = 1; is_row >= 0; is_row--) {
+    int lines = bg->size[1 - is_row];
+    for (int idx = 0; idx < lines; idx++) {
+      line_t forced[2];
+      int valid;
+      if (is_row) {
+        valid = line_deductions(bg->row_filled[idx], bg->row_value[idx],
+                                s->row_count[idx], bg->size[1], s->row_kernel,
+                                &s->row_set, technique_rules[t], forced);
+      } else {
+        valid = line_deductions(bg->col_filled[idx], bg->col_value[idx],
+                                s->col_count[idx], bg->size[0], s->col_kernel,
+                                &s->col_set, technique_rules[t], forced);
+      }
+      if (!valid) {
+        return -1;
+      }
+      if (!(forced[0] | forced[1])) {
+        continue;
+      }
+
+      for (int value = 0; value < 2; value++) {
+        for (line_t cells = forced[value]; cells; cells &= cells - 1) {
+          int k = __builtin_ctzll(cells);
+          if (!(is_row ? solver_assign(s, idx, k, value)
+                       : solver_assign(s, k, idx, value))) {
+            return -1;
+          }
+        }
+      }
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Probes the empty cells with line analysis until one value leads to a
+contradiction, then assigns the other value of that cell only
+Modified parameter :
+-solver_state *s : the search state, where line analysis is stuck
+Return : int, 1 if a cell was filled, 0 if none, -1 on a contradiction
+*/
+static int probe_step(solver_state *s) {
+  bitgrid *bg = &s->grid;
+
+  for (int i = 0; i < bg->size[0]; i++) {
+    line_t empty = ~bg->row_filled[i] & line_mask(bg->size[1]);
+    for (; empty; empty &= empty - 1) {
+      int j = __builtin_ctzll(empty);
+      for (int value = 0; value < 2; value++) {
+        int mark = s->trail_len;
+        int consistent = solver_assign(s, i, j, value) &&
+                         propagate(s, technique_rules[TECH_LINE]);
+        solver_undo(s, mark);
+        if (!consistent) {
+          return solver_assign(s, i, j, 1 - value) ? 1 : -1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/* Applies the easiest technique that fills at least one cell. Pairs and gaps
+run until they are stuck; a harder technique only fills the cells it forces
+itself, on one line or by one probe, so that the cells following from them
+are left to the easier techniques again and counted as theirs
+Modified parameters :
+-solver_state *s : the search state
+-difficulty_report *report : counts the step
+Return : int, the technique used, -1 if none made progress, -2 on a
+contradiction
+*/
+static int easiest_step(solver_state *s, difficulty_report *report) {
+  for (int t = TECH_ADJACENT; t <= TECH_PROBE; t++) {
+    int before = s->trail_len;
+    int valid;
+
+    if (t == TECH_ADJACENT) {
+      valid = propagate(s, technique_rules[t]);
+    } else if (t == TECH_PROBE) {
+      valid = probe_step(s) >= 0;
+    } else {
+      valid = line_step(s, t) >= 0;
+    }
+
+    if (!valid) {
+      return -2;
+    }
+    if (s->trail_len > before) {
+      report->steps[t]++;
+      report->cells[t] += s->trail_len - before;
+      return t;
+    }
+  }
+  return -1;
+}
+
+/* Turns the counters of a report into a score and a tier. The tier only
+depends on the hardest technique needed; the score also grows with the number
+of steps of each technique, to order puzzles of the same tier
+Modified parameter :
+-difficulty_report *report : the report to complete
+*/
+static void score_report(difficulty_report *report) {
+  report->score = 0;
+  for (int t = 0; t < TECHNIQUE_COUNT; t++) {
+    report->score += technique_weight[t] * report->steps[t];
+    if (report->steps[t]) {
+      report->hardest = t;
+    }
+  }
+
+  if (report->hardest <= TECH_QUOTA) {
+    report->tier = TIER_EASY;
+  } else if (report->hardest == TECH_DUPLICATE) {
+    report->tier = TIER_MEDIUM;
+  } else if (report->hardest == TECH_LINE) {
+    report->tier = TIER_HARD;
+  } else {
+    report->tier = TIER_EXPERT;
+  }
+}
+
+/** Rates a packed puzzle.
+
+Copied parameter:
+ - const bitgrid *puzzle: the puzzle, empty cells unset
+
+Modified parameter:
+ - difficulty_report *report: receives the techniques used and the rating
+
+Returns:
+ - int: 1 if the puzzle was solved, 0 if it has no solution
+**/
+int rate_puzzle(const bitgrid *puzzle, difficulty_report *report) {
+  solver_state s;
+
+  memset(report, 0, sizeof(difficulty_report));
+  if (!solver_load(&s, puzzle)) {
+    return 0;
+  }
+
+  int next[2];
+  while (solver_next_cell(&s, next)) {
+    int technique = easiest_step(&s, report);
+    if (technique == -2) {
+      return 0;
+    }
+    if (technique == -1) {
+      /* Every technique is stuck: the rest needs guessing */
+      int before = s.trail_len;
+      if (!rate_search(&s, report, 1)) {
+        return 0;
+      }
+      report->cells[TECH_SEARCH] += s.trail_len - before;
+      report->steps[TECH_SEARCH] = report->search_nodes;
+      break;
+    }
+  }
+
+  score_report(report);
+  return 1;
+}
+
+/** Rates a puzzle given as an int grid.
+
+Copied parameters:
+ - int **grid: the puzzle, -1 for empty cells
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+Modified parameter:
+ - difficulty_report *report: receives the techniques used and the rating
+
+Returns:
+ - int: 1 if the puzzle was solved, 0 if it has no solution
+**/
+int rate_grid(int **grid, int grid_size[2], difficulty_report *report) {
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return rate_puzzle(&bg, report);
+}
+
+/* Appends to a trace the cells assigned since a trail mark
+Copied parameters :
+-const solver_state *s : the search state
+-int mark : trail length before the step
+-int technique : the technique of the step
+Modified parameter :
+-solve_trace *trace : the trace
+*/
+static void trace_cells(const solver_state *s, int mark, int technique,
+                        solve_trace *trace) {
+  for (int k = mark; k < s->trail_len; k++) {
+    int i = s->trail[k] / MAX_GRID_SIZE, j = s->trail[k] % MAX_GRID_SIZE;
+    trace_step *step = &trace->steps[trace->length++];
+    step->row = i;
+    step->col = j;
+    step->value = bitgrid_get(&s->grid, i, j);
+    step->technique = technique;
+  }
+}
+
+/** Records the order in which a person could fill a puzzle, and why.
+
+Each step uses the easiest technique that still fills a cell, like the rater.
+When every technique is stuck, the first empty cell is taken from the solution
+(a TECH_SEARCH step) and the deductions go on from there.
+
+Copied parameters:
+ - const bitgrid *puzzle: the puzzle, empty cells unset
+ - const bitgrid *solution: a solution of the puzzle
+
+Modified parameter:
+ - solve_trace *trace: receives one step per empty cell of the puzzle
+
+Returns:
+ - int: 1 if the trace reaches the solution, 0 if the puzzle contradicts it
+**/
+int trace_puzzle(const bitgrid *puzzle, const bitgrid *solution,
+                 solve_trace *trace) {
+  solver_state s;
+  difficulty_report report;
+
+  trace->length = 0;
+  if (!solver_load(&s, puzzle)) {
+    return 0;
+  }
+
+  int next[2];
+  while (solver_next_cell(&s, next)) {
+    int mark = s.trail_len;
+    int technique = easiest_step(&s, &report);
+
+    if (technique == -2) {
+      return 0;
+    }
+    if (technique == -1) {
+      technique = TECH_SEARCH;
+      if (!solver_assign(&s, next[0], next[1],
+                         bitgrid_get(solution, next[0], next[1]))) {
+        return 0;
+      }
+    }
+    trace_cells(&s, mark, technique, trace);
+  }
+
+  return 1;
+}
+
+/** Makes a puzzle easier with clues of its solution: while its trace needs a
+technique harder than the tier allows, the first cell filled that way becomes
+a clue. Clues only remove solutions, so a unique puzzle stays unique. One clue
+can spare several hard steps, so the puzzle may end in an easier tier than
+asked.
+
+Copied parameters:
+ - const bitgrid *solution: a solution of the puzzle
+ - int tier: the hardest tier allowed, one of the TIER_* values
+
+Modified parameter:
+ - bitgrid *puzzle: the puzzle, which receives the clues
+
+Returns:
+ - int: the number of clues added, -1 if the puzzle contradicts the solution
+**/
+int ease_puzzle(bitgrid *puzzle, const bitgrid *solution, int tier) {
+  solve_trace trace;
+  int added = 0;
+
+  for (;;) {
+    if (!trace_puzzle(puzzle, solution, &trace)) {
+      return -1;
+    }
+
+    int k = 0;
+    while (k < trace.length && trace.steps[k].technique <= tier_hardest[tier]) {
+      k++;
+    }
+    if (k == trace.length) {
+      return added;
+    }
+    bitgrid_set(puzzle, trace.steps[k].row, trace.steps[k].col,
+                trace.steps[k].value);
+    added++;
+  }
+}
+
+/** Gets the name of a technique.
+
+Copied parameter:
+ - int technique: one of the TECH_* values
+
+Returns:
+ - const char*: its name
+**/
+const char *technique_name(int technique) {
+  return technique_names[technique];
+}
+
+/** Gets the name of a tier.
+
+Copied parameter:
+ - int tier: one of the TIER_* values
+
+Returns:
+ - const char*: its name
+**/
+const char *tier_name(int tier) { return tier_names[tier]; }
@@ -0,0 +1,58 @@
+#ifndef DIFFICULTY_FILE
+#define DIFFICULTY_FILE
+
+#include "bitboard.h"
+
+/* Deduction techniques, from the easiest to the hardest */
+#define TECH_ADJACENT 0
+#define TECH_QUOTA 1
+#define TECH_DUPLICATE 2
+#define TECH_LINE 3
+#define TECH_PROBE 4
+#define TECH_SEARCH 5
+#define TECHNIQUE_COUNT 6
+
+#define TIER_EASY 0
+#define TIER_MEDIUM 1
+#define TIER_HARD 2
+#define TIER_EXPERT 3
+#define TIER_COUNT 4
+
+/* How a puzzle was solved by the rater: for each technique, the number of
+steps in which it was the easiest one still making progress and the number of
+cells those steps filled */
+typedef struct difficulty_report {
+  int steps[TECHNIQUE_COUNT];
+  int cells[TECHNIQUE_COUNT];
+  int hardest;
+  int search_nodes;
+  int search_depth;
+  int score;
+  int tier;
+} difficulty_report;
+
+/* One cell of a solve trace: where, what, and the technique that forced it
+(TECH_SEARCH when no technique could, and the cell was taken from the
+solution) */
+typedef struct trace_step {
+  unsigned char row;
+  unsigned char col;
+  unsigned char value;
+  unsigned char technique;
+} trace_step;
+
+/* Every empty cell of a puzzle in the order a person could deduce them */
+typedef struct solve_trace {
+  int length;
+  trace_step steps[MAX_GRID_SIZE * MAX_GRID_SIZE];
+} solve_trace;
+
+int rate_puzzle(const bitgrid *puzzle, difficulty_report *report);
+int rate_grid(int **grid, int grid_size[2], difficulty_report *report);
+int trace_puzzle(const bitgrid *puzzle, const bitgrid *solution,
+                 solve_trace *trace);
+int ease_puzzle(bitgrid *puzzle, const bitgrid *solution, int tier);
+const char *technique_name(int technique);
+const char *tier_name(int tier);
+
+#endif
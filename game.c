@@ -2,25 +2,206 @@
  * FILENAME: game.c
  *
  * DESCRIPTION:
- *        Menu and game-related utilities.
+ *        Menu and game-related utilities. When a game starts, the puzzle is
+ *        solved once step by step (see trace_puzzle); hints and autoplay then
+ *        read the next step of that trace, with the technique behind it.
+ *        Puzzles of the size chosen in the menu are generated ahead of time
+ *        by a producer thread, so new games start at once.
  *
  * PUBLIC FUNCTIONS:
  *        void autogame(int grid_size[2])
  *        void menu()
  *        void get_move(int *i, int *j, int *move, int grid_size[2]);
  *        void game(int grid_size[2]);
+ *        void set_game_bank(const puzzle_bank *bank);
  *
  * AUTHORS: Audrey Damiba & Melissa Lacheb
  **/
 
 #include "game.h"
 #include "backtracking.h"
+#include "bank.h"
+#include "bitboard.h"
 #include "constants.h"
+#include "difficulty.h"
+#include "generator.h"
+#include "pool.h"
+#include "render.h"
+#include "rng.h"
 #include "rules.h"
 #include "utils.h"
 
 #include <stdio.h>
 
+/* Puzzles generated ahead of time for the games */
+#define GAME_POOL_SIZE 4
+
+/* Bank the games take their puzzles from, NULL to generate them */
+static const puzzle_bank *game_bank = NULL;
+
+/* Pool of the size chosen last, when game_pool_size[0] is not 0 */
+static puzzle_pool game_pool;
+static int game_pool_size[2] = {0, 0};
+
+/*Chooses the puzzle bank used by the next games
+Copied parameter :
+-const puzzle_bank *bank : an open bank, NULL to generate the puzzles
+*/
+void set_game_bank(const puzzle_bank *bank) { game_bank = bank; }
+
+/*Stops the producer of the game pool, if it runs
+*/
+static void stop_game_pool(void) {
+  if (game_pool_size[0]) {
+    pool_stop(&game_pool);
+    game_pool_size[0] = 0;
+    game_pool_size[1] = 0;
+  }
+}
+
+/*Starts generating puzzles of a size in the background, unless they come
+from a bank or are already being generated
+Copied parameter :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+*/
+static void start_game_pool(int grid_size[2]) {
+  if (game_bank && game_bank->size[0] == grid_size[0] &&
+      game_bank->size[1] == grid_size[1]) {
+    return;
+  }
+  if (game_pool_size[0] == grid_size[0] &&
+      game_pool_size[1] == grid_size[1]) {
+    return;
+  }
+
+  stop_game_pool();
+  pool_start(&game_pool, grid_size, GAME_POOL_SIZE, 1, 0,
+             rng_next(rng_thread()));
+  game_pool_size[0] = grid_size[0];
+  game_pool_size[1] = grid_size[1];
+}
+
+/*Takes a puzzle of the game pool
+Copied parameter :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+Modified parameter :
+-pool_entry *entry : receives the puzzle
+Return : int, 0 if the pool does not hold puzzles of that size
+*/
+static int take_pool_puzzle(int grid_size[2], pool_entry *entry) {
+  return game_pool_size[0] == grid_size[0] &&
+         game_pool_size[1] == grid_size[1] &&
+         pool_take(&game_pool, POOL_ANY, entry) >= 0;
+}
+
+/*Gets a new puzzle: a random one of the bank when a bank of that size is
+loaded, one of the game pool, or a newly generated one otherwise, and prints
+its ID
+Copied parameter :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+Modified parameters :
+-int ***solution : receives the solved grid
+-int ***mask : receives the mask of the clues
+*/
+static void new_puzzle(int grid_size[2], int ***solution, int ***mask) {
+  bitgrid full, puzzle;
+  bank_meta meta;
+  uint64_t seed = rng_next(rng_thread());
+  int found = 0;
+
+  if (game_bank && game_bank->count > 0 &&
+      game_bank->size[0] == grid_size[0] &&
+      game_bank->size[1] == grid_size[1]) {
+    found = bank_get(game_bank, seed % game_bank->count, &full, &puzzle,
+                     &meta);
+    seed = meta.seed;
+  }
+  pool_entry entry;
+  if (!found && take_pool_puzzle(grid_size, &entry)) {
+    found = 1;
+    full = entry.solution;
+    puzzle = entry.puzzle;
+    seed = entry.seed;
+  }
+  if (!found) {
+    generate_puzzle(seed, grid_size, &full, &puzzle);
+  }
+
+  *solution = create_grid(grid_size, -1);
+  *mask = create_grid(grid_size, INVALID_MASK);
+  bitgrid_to_grid(&full, *solution);
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      if (bitgrid_get(&puzzle, i, j) != -1) {
+        (*mask)[i][j] = VALID_MASK;
+      }
+    }
+  }
+
+  char id[PUZZLE_ID_LENGTH];
+  format_puzzle_id(id, grid_size, seed);
+  printf(BLU "\nPuzzle %s\n" RESET, id);
+}
+
+/*Records the solve trace of a puzzle
+Copied parameters :
+-int **grid : the puzzle, -1 for empty cells
+-int **solution : its solved grid
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+Modified parameter :
+-solve_trace *trace : receives the trace, empty if the puzzle contradicts the
+ solution
+*/
+static void start_trace(int **grid, int **solution, int grid_size[2],
+                        solve_trace *trace) {
+  bitgrid puzzle, full;
+
+  bitgrid_from_grid(&puzzle, grid, grid_size);
+  bitgrid_from_grid(&full, solution, grid_size);
+  if (!trace_puzzle(&puzzle, &full, trace)) {
+    trace->length = 0;
+  }
+}
+
+/*Finds the next step of the trace that is not on the grid yet. Steps before
+the cursor are already on the grid, so each step is passed over once
+Copied parameters :
+-int **grid : the grid being played
+-const solve_trace *trace : the trace of the puzzle
+Modified parameter :
+-int *cursor : index of the first step that may be missing, moved forward
+Return : const trace_step*, the step, NULL when the grid matches the trace
+*/
+static const trace_step *next_step(int **grid, const solve_trace *trace,
+                                   int *cursor) {
+  while (*cursor < trace->length) {
+    const trace_step *step = &trace->steps[*cursor];
+    if (grid[step->row][step->col] != step->value) {
+      return step;
+    }
+    (*cursor)++;
+  }
+  return NULL;
+}
+
+/*Prints a step of the trace as a move and the reason for it
+Copied parameters :
+-const char *label : text printed before the move
+-const trace_step *step : the step
+*/
+static void print_step(const char *label, const trace_step *step) {
+  char name[3];
+  column_name(step->col, name);
+
+  if (step->technique == TECH_SEARCH) {
+    printf(GREEN "%s: %d at (%d,%s), no rule can tell it yet" RESET, label,
+           step->value, step->row + 1, name);
+  } else {
+    printf(GREEN "%s: %d at (%d,%s), by %s" RESET, label, step->value,
+           step->row + 1, name, technique_name(step->technique));
+  }
+}
+
 /*Gets the move the player wants to do when they play
 Copied parameters :
 -int *i, int *j :
@@ -29,11 +210,11 @@ Copied parameters :
 */
 void get_move(int *i, int *j, int *move, int grid_size[2]) {
   do {
-    char col_name;
+    char col_name[3] = "";
     printf("Where do you want to move? (row,column)\n");
-    scanf("%d,%c", i, &col_name);
+    scanf("%d,%2s", i, col_name);
 
-    *j = ((int)col_name) - 65;
+    *j = column_index(col_name);
     *i -= 1;
 
     if (*j < 0 || *i < 0 || *i >= grid_size[0] || *j >= grid_size[1]) {
@@ -60,8 +241,8 @@ void game(int grid_size[2]) {
   int lives = 3;
   int clues = 3;
 
-  int **correct_grid = generate_grid(grid_size);
-  int **mask = generate_mask(grid_size);
+  int **correct_grid, **mask;
+  new_puzzle(grid_size, &correct_grid, &mask);
 
   int choice;
   do {
@@ -82,21 +263,27 @@ void game(int grid_size[2]) {
     if (choice < 1 || choice > 6) {
       printf(RED "Invalid choice." RESET);
     } else if (choice == 1) {
+      free_grid(mask);
       mask = generate_mask_from_user(grid_size);
     } else if (choice == 2) {
-      mask = generate_mask(grid_size);
+      free_grid(mask);
+      mask = generate_unique_mask(correct_grid, grid_size);
       printf(BLU "\nNew mask\n" RESET);
       print_grid(mask, grid_size);
     } else if (choice == 3) {
       printf(BLU "\nMask\n" RESET);
       print_grid(mask, grid_size);
       printf(BLU "\n\nGrid after mask\n" RESET);
-      print_grid(get_grid_from_mask(mask, correct_grid, grid_size), grid_size);
+      int **masked = get_grid_from_mask(mask, correct_grid, grid_size);
+      print_grid(masked, grid_size);
+      free_grid(masked);
       printf("\n");
     } else if (choice == 4) {
       printf(BLU "\nOld base grid\n" RESET);
       print_grid(correct_grid, grid_size);
-      correct_grid = generate_grid(grid_size);
+      free_grid(correct_grid);
+      free_grid(mask);
+      new_puzzle(grid_size, &correct_grid, &mask);
       printf(GREEN "\nNew base grid generated!\n\n" RESET);
     } else if (choice == 5) {
       printf(YELLOW "\nBase grid\n" RESET);
@@ -105,10 +292,30 @@ void game(int grid_size[2]) {
   } while (choice != 6);
 
   int **grid = get_grid_from_mask(mask, correct_grid, grid_size);
+  free_grid(mask);
 
-  while (!is_solved(grid, grid_size)) {
+  /* Packed copy of grid, kept in step with it so that the checks after each
+  move do not pack the whole grid again */
+  bitgrid board;
+  bitgrid_from_grid(&board, grid, grid_size);
+
+  solve_trace trace;
+  int cursor = 0;
+  start_trace(grid, correct_grid, grid_size, &trace);
+
+  int empty = 0;
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      empty += grid[i][j] == -1;
+    }
+  }
+
+  renderer r;
+  renderer_init(&r, grid_size, 1);
+
+  while (empty > 0) {
     printf("\n");
-    print_grid(grid, grid_size);
+    render_grid(&r, grid);
 
     printf("\nCLUES  ");
     for (int i = 0; i < clues; i++) {
@@ -136,41 +343,71 @@ void game(int grid_size[2]) {
         int i, j, move;
         get_move(&i, &j, &move, grid_size);
 
+        int previous = grid[i][j];
         grid[i][j] = move;
+        bitgrid_set(&board, i, j, move);
 
-        if (!is_valid_grid(grid, grid_size, 1)) {
+        if (!bitgrid_is_valid(&board, 1)) {
           printf(YELLOW "Invalid move: you lost a life!" RESET);
           lives--;
-          grid[i][j] = -1;
+          grid[i][j] = previous;
+          if (previous == -1) {
+            bitgrid_unset(&board, i, j);
+          } else {
+            bitgrid_set(&board, i, j, previous);
+          }
           if (lives == 0) {
             printf(RED "You lost!\n" RESET);
             printf("Press any key to continue...\n");
             getchar();
+            renderer_free(&r);
+            free_grid(grid);
+            free_grid(correct_grid);
             return;
           }
-        } else if (grid[i][j] != correct_grid[i][j]) {
-          printf(YELLOW "Though this move is valid, it might not be the right "
-                        "one 🤔" RESET);
+        } else {
+          empty -= previous == -1;
+          if (grid[i][j] != correct_grid[i][j]) {
+            /* The trace passed over this cell if it was right before */
+            cursor = 0;
+            printf(YELLOW "Though this move is valid, it might not be the "
+                          "right one 🤔" RESET);
+          }
         }
       } else if (action == 2) {
-        if (clues > 0) {
-          int *move = find_next(grid, grid_size);
-          grid[move[0]][move[1]] = correct_grid[move[0]][move[1]];
-          printf(GREEN "HINT: Added %d at (%d, %d)" RESET,
-                 correct_grid[move[0]][move[1]], move[0], move[1]);
+        const trace_step *step = next_step(grid, &trace, &cursor);
+        if (clues > 0 && step) {
+          empty -= grid[step->row][step->col] == -1;
+          grid[step->row][step->col] = step->value;
+          bitgrid_set(&board, step->row, step->col, step->value);
+          print_step("HINT", step);
           clues--;
+        } else if (clues > 0) {
+          printf(YELLOW "No hint available for this grid!" RESET);
         } else {
           printf(YELLOW "No more clues available!" RESET);
         }
       } else if (action == 3) {
+        renderer_free(&r);
+        free_grid(grid);
+        free_grid(correct_grid);
         return;
       }
     } while (action < 1 || action > 3);
   }
 
-  print_grid(grid, grid_size);
-  printf(CYN "\n\nC O N G R A T U L A T I O N S  !\n\n" GREEN
-             "Well done! You solved the grid 🎉🎉\n" RESET);
+  render_grid(&r, grid);
+  renderer_free(&r);
+  if (bitgrid_is_solved(&board)) {
+    printf(CYN "\n\nC O N G R A T U L A T I O N S  !\n\n" GREEN
+               "Well done! You solved the grid 🎉🎉\n" RESET);
+  } else {
+    printf(YELLOW "\nThe grid is full but breaks a rule. Here is the "
+                  "solution:\n\n" RESET);
+    print_grid(correct_grid, grid_size);
+  }
+  free_grid(grid);
+  free_grid(correct_grid);
 }
 
 /* Solve the grid automatically when a key is pressd by the user
@@ -178,24 +415,36 @@ Copied parameters :
 -int grid_size[2] : contains the size of the grid in the X and Y dimension.
 */
 void autogame(int grid_size[2]) {
-  int **correct_grid = generate_grid(grid_size);
-  int **mask = generate_mask(grid_size);
+  int **correct_grid, **mask;
+  new_puzzle(grid_size, &correct_grid, &mask);
   int **grid = get_grid_from_mask(mask, correct_grid, grid_size);
+  free_grid(mask);
+
+  solve_trace trace;
+  start_trace(grid, correct_grid, grid_size, &trace);
+
+  renderer r;
+  renderer_init(&r, grid_size, 1);
+
+  for (int k = 0; k < trace.length; k++) {
+    const trace_step *step = &trace.steps[k];
 
-  while (!is_solved(grid, grid_size)) {
     printf("\n");
-    print_grid(grid, grid_size);
+    render_grid(&r, grid);
     printf("\n");
 
-    int *move = find_next(grid, grid_size);
-    grid[move[0]][move[1]] = correct_grid[move[0]][move[1]];
+    grid[step->row][step->col] = step->value;
+    print_step("NEXT", step);
 
-    printf("Press any key to continue...\n");
+    printf("\nPress any key to continue...\n");
     getchar();
   }
 
-  printf(GREEN "The grid is solved !\n\n" RESET);
-  print_grid(grid, grid_size);
+  render_grid(&r, grid);
+  renderer_free(&r);
+  printf(GREEN "\nThe grid is solved !\n\n" RESET);
+  free_grid(grid);
+  free_grid(correct_grid);
 }
 
 /* Main menu that gets what the player wants to do
@@ -206,6 +455,11 @@ void menu() {
   int action_choice = 0;
   int size_choice;
 
+  if (game_bank) {
+    printf(GREEN "Puzzle bank loaded: %u puzzles of size %dx%d.\n" RESET,
+           game_bank->count, game_bank->size[0], game_bank->size[1]);
+  }
+
   do {
     printf(MAG "\n\n      ════════════ ❀•°❀°•❀ ════════════\n"
                " Welcome to the game! What do you want to do?\n"
@@ -235,9 +489,11 @@ void menu() {
                    "What size of grid do you want?\n\n"
                    " - Type 1 for a 4x4 grid\n"
                    " - Type 2 for a 8x8 grid\n"
-                   "- Type 3 for a 12x12 grid\n"
+                   " - Type 3 for a 12x12 grid\n"
+                   " - Type 4 for another size (even, up to %dx%d)\n"
                    ".・。.・゜✭・.  " BOLD UNDERLINE "Grid Size" RESET CYN
-                   "  .・。.・゜✭・.\n\n" RESET);
+                   "  .・。.・゜✭・.\n\n" RESET,
+               MAX_GRID_SIZE, MAX_GRID_SIZE);
         scanf("%d", &size_choice);
 
         if (size_choice == 1) {
@@ -249,19 +505,43 @@ void menu() {
         } else if (size_choice == 3) {
           grid_size[0] = 12;
           grid_size[1] = 12;
+        } else if (size_choice == 4) {
+          int size;
+          do {
+            printf(CYN "\nWhich size? (even number from 4 to %d)\n\n" RESET,
+                   MAX_GRID_SIZE);
+            scanf("%d", &size);
+            if (size < 4 || size > MAX_GRID_SIZE || size % 2) {
+              printf(RED "Invalid size.\n" RESET);
+            }
+          } while (size < 4 || size > MAX_GRID_SIZE || size % 2);
+          grid_size[0] = size;
+          grid_size[1] = size;
         } else {
           printf(RED "Invalid size choice.\n" RESET);
         }
       } while (size_choice < 1 || size_choice > 4);
 
+      start_game_pool(grid_size);
       if (action_choice == 1) {
         game(grid_size);
       } else if (action_choice == 2) {
         autogame(grid_size);
       } else if (action_choice == 3) {
         printf(GREEN "\nHere is your random grid!\n" RESET);
-        print_grid(generate_grid(grid_size), grid_size);
+        pool_entry entry;
+        int **grid;
+        if (take_pool_puzzle(grid_size, &entry)) {
+          grid = create_grid(grid_size, -1);
+          bitgrid_to_grid(&entry.solution, grid);
+        } else {
+          grid = generate_grid(grid_size);
+        }
+        print_grid(grid, grid_size);
+        free_grid(grid);
       }
     }
   } while (action_choice != 4);
+
+  stop_game_pool();
 }
@@ -1,9 +1,12 @@
 #ifndef MENU_FILE
 #define MENU_FILE
 
+#include "bank.h"
+
 void autogame(int grid_size[2]);
 void menu();
 void get_move(int *i, int *j, int *move, int grid_size[2]);
 void game(int grid_size[2]);
+void set_game_bank(const puzzle_bank *bank);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+/**
+ * FILENAME: generator.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Puzzle generation: hides cells of a solution grid for as long as the
+ *        puzzle keeps a single solution. A puzzle only depends on its size
+ *        and on a 64-bit seed, so it can be shared as an ID ("12x12-" and
+ *        the seed in hexadecimal) and made again anywhere.
+ *
+ * PUBLIC FUNCTIONS:
+ *        void bitgrid_unique_puzzle(const bitgrid *solution, bitgrid *puzzle,
+ *                                   rng *random)
+ *        int **generate_unique_mask(int **solution, int grid_size[2])
+ *        int generate_puzzle(uint64_t seed, int grid_size[2],
+ *                            bitgrid *solution, bitgrid *puzzle)
+ *        void format_puzzle_id(char id[PUZZLE_ID_LENGTH], int grid_size[2],
+ *                              uint64_t seed)
+ *        int parse_puzzle_id(const char *id, int grid_size[2],
+ *                            uint64_t *seed)
+ *
+ **/
+
+#include "generator.h"
+#include "backtracking.h"
+#include "constants.h"
+#include "rng.h"
+#include "utils.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/* Nodes a uniqueness check may visit before the clue is kept */
+#define UNIQUENESS_NODES 200
+
+/** Removes clues from a solution in random order, keeping a clue only when
+removing it would allow another solution. The puzzle is unique as long as no
+solution puts the opposite value in the removed cell, so each check is a
+search for a single solution of the puzzle with that cell flipped. A check
+that needs more than UNIQUENESS_NODES nodes keeps the clue: the puzzle stays
+unique, only a little less sparse, and large grids stay fast.
+
+Copied parameter:
+ - const bitgrid *solution: a solved grid
+
+Modified parameters:
+ - bitgrid *puzzle: receives the puzzle
+ - rng *random: draws the order in which the clues are removed
+
+No return
+**/
+void bitgrid_unique_puzzle(const bitgrid *solution, bitgrid *puzzle,
+                           rng *random) {
+  int rows = solution->size[0];
+  int cols = solution->size[1];
+  int cells = rows * cols;
+  int order[MAX_GRID_SIZE * MAX_GRID_SIZE];
+
+  for (int k = 0; k < cells; k++) {
+    order[k] = k;
+  }
+  for (int k = cells - 1; k > 0; k--) {
+    int swap = rng_int(random, k + 1);
+    int tmp = order[k];
+    order[k] = order[swap];
+    order[swap] = tmp;
+  }
+
+  *puzzle = *solution;
+  for (int k = 0; k < cells; k++) {
+    int i = order[k] / cols;
+    int j = order[k] % cols;
+    int value = bitgrid_get(solution, i, j);
+
+    bitgrid trial = *puzzle;
+    bitgrid_unset(&trial, i, j);
+    bitgrid_set(&trial, i, j, 1 - value);
+
+    if (bitgrid_solvable(&trial, UNIQUENESS_NODES) == 0) {
+      bitgrid_unset(puzzle, i, j);
+    }
+  }
+}
+
+/** Generates a mask that leaves a puzzle with a single solution, with the
+generator of the calling thread.
+
+Copied parameters:
+ - int **solution: 2D array which contains a solution grid
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+Returns:
+ - int**: the resulting mask
+**/
+int **generate_unique_mask(int **solution, int grid_size[2]) {
+  int **mask = create_grid(grid_size, INVALID_MASK);
+  bitgrid full, puzzle;
+
+  bitgrid_from_grid(&full, solution, grid_size);
+  bitgrid_unique_puzzle(&full, &puzzle, rng_thread());
+
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      if (bitgrid_get(&puzzle, i, j) != -1) {
+        mask[i][j] = VALID_MASK;
+      }
+    }
+  }
+
+  return mask;
+}
+
+/** Generates the puzzle of a seed: the same seed and size always give the
+same solution and the same clues, on any thread.
+
+Copied parameters:
+ - uint64_t seed: the seed of the puzzle
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+Modified parameters:
+ - bitgrid *solution: receives the solved grid
+ - bitgrid *puzzle: receives the puzzle
+
+Returns:
+ - int: 1 if a puzzle was generated, 0 if the size has no valid grid
+**/
+int generate_puzzle(uint64_t seed, int grid_size[2], bitgrid *solution,
+                    bitgrid *puzzle) {
+  rng random;
+
+  rng_init(&random, seed);
+  if (!bitgrid_generate(solution, grid_size, &random)) {
+    return 0;
+  }
+  bitgrid_unique_puzzle(solution, puzzle, &random);
+  return 1;
+}
+
+/** Writes the ID of a puzzle, such as "12x12-00000000075bcd15".
+
+Copied parameters:
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+ - uint64_t seed: the seed of the puzzle
+
+Modified parameter:
+ - char id[PUZZLE_ID_LENGTH]: receives the ID
+
+No return
+**/
+void format_puzzle_id(char id[PUZZLE_ID_LENGTH], int grid_size[2],
+                      uint64_t seed) {
+  snprintf(id, PUZZLE_ID_LENGTH, "%dx%d-%016" PRIx64, grid_size[0],
+           grid_size[1], seed);
+}
+
+/** Reads the size and the seed of a puzzle from its ID.
+
+Copied parameter:
+ - const char *id: the ID
+
+Modified parameters:
+ - int grid_size[2]: receives the size of the grid
+ - uint64_t *seed: receives the seed
+
+Returns:
+ - int: 1 if the ID is valid, 0 otherwise
+**/
+int parse_puzzle_id(const char *id, int grid_size[2], uint64_t *seed) {
+  int end = 0;
+
+  if (sscanf(id, "%dx%d-%" SCNx64 "%n", &grid_size[0], &grid_size[1], seed,
+             &end) != 3 ||
+      id[end] != '\0') {
+    return 0;
+  }
+  return grid_size[0] >= 2 && grid_size[0] <= MAX_GRID_SIZE &&
+         grid_size[1] >= 2 && grid_size[1] <= MAX_GRID_SIZE &&
+         grid_size[0] % 2 == 0 && grid_size[1] % 2 == 0;
+}
@@ -0,0 +1,19 @@
+#ifndef GENERATOR_FILE
+#define GENERATOR_FILE
+
+#include "bitboard.h"
+#include "rng.h"
+
+/* Characters of a puzzle ID, "64x64-" and 16 hexadecimal digits */
+#define PUZZLE_ID_LENGTH 24
+
+void bitgrid_unique_puzzle(const bitgrid *solution, bitgrid *puzzle,
+                           rng *random);
+int **generate_unique_mask(int **solution, int grid_size[2]);
+int generate_puzzle(uint64_t seed, int grid_size[2], bitgrid *solution,
+                    bitgrid *puzzle);
+void format_puzzle_id(char id[PUZZLE_ID_LENGTH], int grid_size[2],
+                      uint64_t seed);
+int parse_puzzle_id(const char *id, int grid_size[2], uint64_t *seed);
+
+#endif
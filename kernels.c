@@ -0,0 +1,147 @@
+/**
+ * FILENAME: kernels.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Size-specialized kernels of the line analysis. The analysis is
+ *        written once in line_kernel.h and compiled for every line size from
+ *        10 to 16, fully unrolled, and once for any size. Lines of 4 to 8
+ *        cells are read from a table holding the answer for every partial
+ *        line, filled on first use. The kernel of a size is chosen when a
+ *        search state is loaded.
+ *
+ * PUBLIC FUNCTIONS:
+ *        completion_kernel get_completion_kernel(int line_size)
+ *        void set_specialized_kernels(int enabled)
+ *        int specialized_kernels(void)
+ *
+ **/
+
+#include "kernels.h"
+
+#include <pthread.h>
+
+#define KERNEL_NAME completions_any
+#include "line_kernel.h"
+
+#define KERNEL_NAME completions_10
+#define KERNEL_SIZE 10
+#include "line_kernel.h"
+
+#define KERNEL_NAME completions_12
+#define KERNEL_SIZE 12
+#include "line_kernel.h"
+
+#define KERNEL_NAME completions_14
+#define KERNEL_SIZE 14
+#include "line_kernel.h"
+
+#define KERNEL_NAME completions_16
+#define KERNEL_SIZE 16
+#include "line_kernel.h"
+
+/* Tables of the small sizes: entry (filled << size) | value holds the cells
+that can hold a 0 in its low byte and those that can hold a 1 in its high
+byte */
+static uint16_t table_4[1 << 8];
+static uint16_t table_6[1 << 12];
+static uint16_t table_8[1 << 16];
+static uint16_t *const tables[TABLE_MAX_SIZE / 2 + 1] = {NULL, NULL, table_4,
+                                                         table_6, table_8};
+static _Atomic int tables_ready[TABLE_MAX_SIZE / 2 + 1];
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic int specialized = 1;
+
+/* Reads the analysis of a line of at most TABLE_MAX_SIZE cells from its table
+Copied parameters :
+-line_t filled, line_t value : the packed line
+-int line_size : the number of cells in the line, with a filled table
+Modified parameter :
+-line_t possible[2] : receives the cells that can hold a 0 and a 1
+*/
+static void completions_table(line_t filled, line_t value, int line_size,
+                              line_t possible[2]) {
+  uint16_t entry =
+      tables[line_size / 2][(filled << line_size) | (value & filled)];
+
+  possible[0] = entry & 0xFF;
+  possible[1] = entry >> 8;
+}
+
+/* Fills the table of a size with the generic kernel, once: only the entries
+whose values are inside the filled cells are ever read
+Copied parameter :
+-int line_size : an even size of at most TABLE_MAX_SIZE
+*/
+static void fill_table(int line_size) {
+  if (tables_ready[line_size / 2]) {
+    return;
+  }
+
+  pthread_mutex_lock(&tables_lock);
+  if (!tables_ready[line_size / 2]) {
+    uint16_t *table = tables[line_size / 2];
+    line_t full = line_mask(line_size);
+
+    for (line_t filled = 0; filled <= full; filled++) {
+      /* Every subset of filled, the empty one last */
+      line_t value = filled;
+      do {
+        line_t possible[2];
+        completions_any(filled, value, line_size, possible);
+        table[(filled << line_size) | value] =
+            (uint16_t)(possible[0] | (possible[1] << 8));
+        value = (value - 1) & filled;
+      } while (value != filled);
+    }
+    tables_ready[line_size / 2] = 1;
+  }
+  pthread_mutex_unlock(&tables_lock);
+}
+
+/** Gets the line analysis kernel of a line size.
+
+Copied parameter:
+ - int line_size: the number of cells of the lines
+
+Returns:
+ - completion_kernel: the kernel of that size, or the generic one when the
+   size has none or the specialized kernels are turned off
+**/
+completion_kernel get_completion_kernel(int line_size) {
+  if (!specialized || line_size % 2 || line_size < SPECIALIZED_MIN_SIZE ||
+      line_size > SPECIALIZED_MAX_SIZE) {
+    return completions_any;
+  }
+
+  switch (line_size) {
+  case 10:
+    return completions_10;
+  case 12:
+    return completions_12;
+  case 14:
+    return completions_14;
+  case 16:
+    return completions_16;
+  default:
+    fill_table(line_size);
+    return completions_table;
+  }
+}
+
+/** Turns the size-specialized kernels on or off, to compare them with the
+generic ones. Only search states loaded afterwards are affected.
+
+Copied parameter:
+ - int enabled: 0 to always use the generic kernels
+**/
+void set_specialized_kernels(int enabled) { specialized = enabled; }
+
+/** Tells whether the size-specialized kernels are used.
+
+Returns:
+ - int: 1 if they are (the default)
+**/
+int specialized_kernels(void) { return specialized; }
@@ -0,0 +1,23 @@
+#ifndef KERNELS_FILE
+#define KERNELS_FILE
+
+#include "bitboard.h"
+
+/* Square sizes with their own solver and validator kernels; the other sizes
+use the generic ones */
+#define SPECIALIZED_MIN_SIZE 4
+#define SPECIALIZED_MAX_SIZE 16
+
+/* Line sizes whose analysis is read from a table of every partial line */
+#define TABLE_MAX_SIZE 8
+
+/* Finds the cells of a partial line that can still hold a 0 (possible[0])
+and a 1 (possible[1]) in a valid completion */
+typedef void (*completion_kernel)(line_t filled, line_t value, int line_size,
+                                  line_t possible[2]);
+
+completion_kernel get_completion_kernel(int line_size);
+void set_specialized_kernels(int enabled);
+int specialized_kernels(void);
+
+#endif
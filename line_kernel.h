@@ -0,0 +1,85 @@
+/* Body of a line analysis kernel, included by kernels.c with KERNEL_NAME
+defined, and KERNEL_SIZE too for a kernel that only handles lines of that
+size. With a constant size every loop is unrolled and the sets of counts stay
+in registers; without it the same code takes the size at run time */
+
+/* Finds which values each cell of a line can take in at least one valid
+completion of the line (no triple, as many zeros as ones). Sets of numbers of
+ones are kept as bitmasks per ending run (0 once, 0 twice, 1 once, 1 twice):
+reach[p][c] is what the p first cells can reach, f0..f3 what the cells after
+the current one can complete. A filled cell clears the masks of the other
+value instead of branching on it
+Copied parameters :
+-line_t filled, line_t value : the packed line
+-int line_size : the number of cells in the line
+Modified parameter :
+-line_t possible[2] : receives the cells that can hold a 0 and a 1
+*/
+static void KERNEL_NAME(line_t filled, line_t value, int line_size,
+                        line_t possible[2]) {
+#ifdef KERNEL_SIZE
+  const int size = KERNEL_SIZE;
+  (void)line_size;
+#else
+  const int size = line_size;
+#endif
+  const int half = size / 2;
+  line_t allow0 = ~(filled & value);
+  line_t allow1 = ~(filled & ~value);
+  uint64_t reach[MAX_GRID_SIZE + 1][4];
+  uint64_t r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+
+#ifdef KERNEL_SIZE
+#pragma GCC unroll 64
+#endif
+  for (int p = 0; p < size; p++) {
+    int low = p + 1 - half > 0 ? p + 1 - half : 0;
+    int high = p + 1 < half ? p + 1 : half;
+    uint64_t range = (((uint64_t)2 << high) - 1) & ~(((uint64_t)1 << low) - 1);
+    uint64_t m0 = -((allow0 >> p) & 1) & range;
+    uint64_t m1 = -((allow1 >> p) & 1) & range;
+    uint64_t after1 = p == 0 ? 1 : r2 | r3;
+    uint64_t after0 = p == 0 ? 1 : r0 | r1;
+
+    r1 = r0 & m0;
+    r0 = after1 & m0;
+    r3 = (r2 << 1) & m1;
+    r2 = (after0 << 1) & m1;
+    reach[p + 1][0] = r0;
+    reach[p + 1][1] = r1;
+    reach[p + 1][2] = r2;
+    reach[p + 1][3] = r3;
+  }
+
+  uint64_t f0 = (uint64_t)1 << half, f1 = f0, f2 = f0, f3 = f0;
+  line_t possible0 = 0, possible1 = 0;
+
+#ifdef KERNEL_SIZE
+#pragma GCC unroll 64
+#endif
+  for (int p = size - 1; p >= 0; p--) {
+    possible0 |= (line_t)(((reach[p + 1][0] & f0) | (reach[p + 1][1] & f1)) !=
+                          0)
+                 << p;
+    possible1 |= (line_t)(((reach[p + 1][2] & f2) | (reach[p + 1][3] & f3)) !=
+                          0)
+                 << p;
+
+    uint64_t m0 = -((allow0 >> p) & 1);
+    uint64_t m1 = -((allow1 >> p) & 1);
+    uint64_t g0 = (f1 & m0) | ((f2 >> 1) & m1);
+    uint64_t g1 = (f2 >> 1) & m1;
+    uint64_t g2 = (f0 & m0) | ((f3 >> 1) & m1);
+    uint64_t g3 = f0 & m0;
+    f0 = g0;
+    f1 = g1;
+    f2 = g2;
+    f3 = g3;
+  }
+
+  possible[0] = possible0;
+  possible[1] = possible1;
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_SIZE
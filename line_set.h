@@ -0,0 +1,90 @@
+#ifndef LINE_SET_FILE
+#define LINE_SET_FILE
+
+#include "bitboard.h"
+
+#define LINE_SET_BITS 7
+#define LINE_SET_SLOTS (1 << LINE_SET_BITS)
+
+/* Set of completed lines, keyed by their value word (the line itself is its
+signature). Open addressing with linear probing in twice as many slots as a
+grid has lines, so a lookup touches one or two slots. Removal shifts the
+following entries back instead of leaving tombstones, so the set can follow a
+search that completes and un-completes lines forever. */
+typedef struct line_set {
+  int count;
+  uint64_t occupied[LINE_SET_SLOTS / 64];
+  line_t keys[LINE_SET_SLOTS];
+} line_set;
+
+/* Home slot of a key (Fibonacci hashing) */
+static inline int line_set_slot(line_t key) {
+  return (int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - LINE_SET_BITS));
+}
+
+static inline int line_set_used(const line_set *set, int slot) {
+  return (int)((set->occupied[slot >> 6] >> (slot & 63)) & 1);
+}
+
+/* Empties the set */
+static inline void line_set_clear(line_set *set) {
+  set->count = 0;
+  for (int k = 0; k < LINE_SET_SLOTS / 64; k++) {
+    set->occupied[k] = 0;
+  }
+}
+
+/* Whether key is in the set */
+static inline int line_set_contains(const line_set *set, line_t key) {
+  for (int slot = line_set_slot(key); line_set_used(set, slot);
+       slot = (slot + 1) & (LINE_SET_SLOTS - 1)) {
+    if (set->keys[slot] == key) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Adds key to the set. Returns 0, leaving the set unchanged, when key is
+already in it */
+static inline int line_set_insert(line_set *set, line_t key) {
+  int slot = line_set_slot(key);
+
+  for (; line_set_used(set, slot); slot = (slot + 1) & (LINE_SET_SLOTS - 1)) {
+    if (set->keys[slot] == key) {
+      return 0;
+    }
+  }
+  set->keys[slot] = key;
+  set->occupied[slot >> 6] |= (uint64_t)1 << (slot & 63);
+  set->count++;
+  return 1;
+}
+
+/* Removes key from the set if it is there */
+static inline void line_set_remove(line_set *set, line_t key) {
+  int hole = line_set_slot(key);
+
+  while (line_set_used(set, hole) && set->keys[hole] != key) {
+    hole = (hole + 1) & (LINE_SET_SLOTS - 1);
+  }
+  if (!line_set_used(set, hole)) {
+    return;
+  }
+
+  /* Moves back every following entry whose home slot is not between the
+  hole and its current slot, so that no probe sequence is broken */
+  for (int slot = (hole + 1) & (LINE_SET_SLOTS - 1); line_set_used(set, slot);
+       slot = (slot + 1) & (LINE_SET_SLOTS - 1)) {
+    int home = line_set_slot(set->keys[slot]);
+    if (((slot - home) & (LINE_SET_SLOTS - 1)) >=
+        ((slot - hole) & (LINE_SET_SLOTS - 1))) {
+      set->keys[hole] = set->keys[slot];
+      hole = slot;
+    }
+  }
+  set->occupied[hole >> 6] &= ~((uint64_t)1 << (hole & 63));
+  set->count--;
+}
+
+#endif
@@ -1,9 +1,13 @@
-#include <time.h>
-#include <stdlib.h>
+#include "cli.h"
 #include "game.h"
+#include "rng.h"
 
-int main(){
-  srand(time(NULL));
+int main(int argc, char **argv){
+  if (argc > 1) {
+    return run_cli(argc, argv);
+  }
+
+  rng_seed(rng_random_seed());
   menu();
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,331 @@
+/**
+ * FILENAME: minimize.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Minimal puzzles: every clue of the solution is tried once, in random
+ *        order, and removed when the puzzle stays unique without it. Once a
+ *        clue is needed it stays needed, since removing other clues only adds
+ *        solutions, so one pass leaves a puzzle where no clue can be removed.
+ *        Each worker keeps a single search state for the whole pass, and
+ *        several workers check the next clues at the same time.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int bitgrid_minimal_puzzle(const bitgrid *solution, bitgrid *puzzle,
+ *                                   rng *random, int threads)
+ *        int **generate_minimal_mask(int **solution, int grid_size[2])
+ *
+ **/
+
+#include "minimize.h"
+#include "arena.h"
+#include "backtracking.h"
+#include "constants.h"
+#include "propagation.h"
+#include "solver.h"
+#include "stats.h"
+#include "utils.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Nodes of the quick search of a check, before it starts again with probing
+at every node: most checks end within a few nodes, but a wrong branching near
+the flipped cell can trap a plain search in a huge subtree */
+#define QUICK_NODES 200
+
+#define CLUE_UNDECIDED 0
+#define CLUE_KEPT 1
+#define CLUE_REMOVED 2
+
+/* One pass over the clues: clue k is the cell order[k] of the solution */
+typedef struct minimizer {
+  const bitgrid *solution;
+  int count;
+  int order[MAX_GRID_SIZE * MAX_GRID_SIZE];
+  unsigned char decision[MAX_GRID_SIZE * MAX_GRID_SIZE];
+  int threads;
+  int finished;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+} minimizer;
+
+/* A search state holding the clues from the last one down to the first, each
+followed by what it forces: undoing to marks[k] leaves the clues after k
+already propagated, so a check only places the clues before k */
+typedef struct minimize_worker {
+  minimizer *m;
+  int clue;
+  int removable;
+  solver_state state;
+  int marks[MAX_GRID_SIZE * MAX_GRID_SIZE];
+} minimize_worker;
+
+/* Assigns a clue to its value in the solution, unless it is already forced
+Modified parameter :
+-solver_state *s : the search state
+Copied parameters :
+-const minimizer *m : the pass
+-int k : the clue
+*/
+static void place_clue(solver_state *s, const minimizer *m, int k) {
+  int cols = m->solution->size[1];
+  int i = m->order[k] / cols, j = m->order[k] % cols;
+
+  if (bitgrid_get(&s->grid, i, j) == -1) {
+    solver_assign(s, i, j, bitgrid_get(m->solution, i, j));
+  }
+}
+
+/* Builds the search state of a worker: the clues are placed from the last to
+the first, and each one is propagated before the mark of the previous one
+Modified parameter :
+-minimize_worker *w : the worker
+*/
+static void load_clues(minimize_worker *w) {
+  const minimizer *m = w->m;
+  bitgrid empty;
+
+  bitgrid_init(&empty, (int *)m->solution->size);
+  solver_load(&w->state, &empty);
+  for (int k = m->count - 1; k >= 0; k--) {
+    w->marks[k] = w->state.trail_len;
+    place_clue(&w->state, m, k);
+    propagate(&w->state, RULES_ALL);
+  }
+}
+
+/* Tells whether clue k can be removed from the puzzle made of the clues
+after it and of the clues before it that are not removed: it can when no
+solution puts the other value in its cell. Such a solution usually differs
+from the known one in a few cells only, so the search tries its values first
+Modified parameter :
+-minimize_worker *w : the worker, whose state is left at marks[k] or above
+Copied parameter :
+-int k : the clue, with marks[k] not undone yet
+Return : int
+*/
+static int clue_removable(minimize_worker *w, int k) {
+  const minimizer *m = w->m;
+  solver_state *s = &w->state;
+  int cols = m->solution->size[1];
+  int i = m->order[k] / cols, j = m->order[k] % cols;
+
+  solver_undo(s, w->marks[k]);
+  for (int c = 0; c < k; c++) {
+    if (m->decision[c] != CLUE_REMOVED) {
+      place_clue(s, m, c);
+    }
+  }
+
+  /* Already forced by the other clues, without any search */
+  if (bitgrid_get(&s->grid, i, j) != -1) {
+    return 1;
+  }
+  if (!solver_assign(s, i, j, 1 - bitgrid_get(m->solution, i, j))) {
+    return 1;
+  }
+
+  int mark = s->trail_len;
+  int solvable = search_solvable(s, QUICK_NODES, 0, m->solution);
+  if (solvable == -1) {
+    solver_undo(s, mark);
+    solver_mark_all(s);
+    solvable = search_solvable(s, -1, 1, m->solution);
+  }
+  return !solvable;
+}
+
+/* Worker thread: checks its clue of every window, between two barriers
+Modified parameter :
+-void *arg : the minimize_worker
+Return : NULL
+*/
+static void *minimize_thread(void *arg) {
+  minimize_worker *w = arg;
+  minimizer *m = w->m;
+
+  load_clues(w);
+  for (;;) {
+    pthread_barrier_wait(&m->start);
+    if (m->finished) {
+      break;
+    }
+    if (w->clue >= 0) {
+      w->removable = clue_removable(w, w->clue);
+    }
+    pthread_barrier_wait(&m->done);
+  }
+
+  stats_flush();
+  return NULL;
+}
+
+/* Checks the next undecided clues, one per worker, as if none of them were
+removed, then keeps the answers that still hold: a needed clue stays needed
+whatever is removed before it, but a removable one is only removed if no
+clue of the window before it was, and is checked again otherwise
+Modified parameters :
+-minimizer *m : the pass
+-minimize_worker *workers : the workers, the first one run by this thread
+Copied parameter :
+-int first : the first undecided clue
+Return : int, the first undecided clue afterwards, m->count when done
+*/
+static int run_window(minimizer *m, minimize_worker *workers, int first) {
+  int k = first;
+
+  for (int t = 0; t < m->threads; t++) {
+    while (k < m->count && m->decision[k] != CLUE_UNDECIDED) {
+      k++;
+    }
+    workers[t].clue = k < m->count ? k++ : -1;
+  }
+
+  if (m->threads > 1) {
+    pthread_barrier_wait(&m->start);
+  }
+  workers[0].removable = clue_removable(&workers[0], workers[0].clue);
+  if (m->threads > 1) {
+    pthread_barrier_wait(&m->done);
+  }
+
+  int removed = 0;
+  for (int t = 0; t < m->threads && workers[t].clue >= 0; t++) {
+    if (!workers[t].removable) {
+      m->decision[workers[t].clue] = CLUE_KEPT;
+    } else if (!removed) {
+      m->decision[workers[t].clue] = CLUE_REMOVED;
+      removed = 1;
+    }
+  }
+
+  while (first < m->count && m->decision[first] != CLUE_UNDECIDED) {
+    first++;
+  }
+  return first;
+}
+
+/** Removes clues from a solution until every clue left is needed: removing
+any of them would give the puzzle a second solution. Unlike
+bitgrid_unique_puzzle, every check runs to the end, so the puzzle is minimal
+on any size, at the price of slower checks on large grids.
+
+Copied parameters:
+ - const bitgrid *solution: a solved grid
+ - int threads: the number of threads checking clues at the same time
+
+Modified parameters:
+ - bitgrid *puzzle: receives the puzzle
+ - rng *random: draws the order in which the clues are removed
+
+Returns:
+ - int: the number of clues of the puzzle
+**/
+int bitgrid_minimal_puzzle(const bitgrid *solution, bitgrid *puzzle,
+                           rng *random, int threads) {
+  int count = threads < 1 ? 1 : threads;
+  arena local;
+  size_t mark;
+  arena *scratch = arena_scratch(
+      &local,
+      sizeof(minimizer) +
+          count * (sizeof(minimize_worker) + sizeof(pthread_t)) +
+          3 * ARENA_ALIGN,
+      &mark);
+  if (!scratch) {
+    fprintf(stderr, "Not enough memory to minimize a puzzle.\n");
+    exit(EXIT_FAILURE);
+  }
+  minimizer *m = arena_alloc(scratch, sizeof(minimizer));
+  int cols = solution->size[1];
+
+  m->solution = solution;
+  m->count = solution->size[0] * cols;
+  m->threads = count;
+  m->finished = 0;
+  for (int k = 0; k < m->count; k++) {
+    m->order[k] = k;
+    m->decision[k] = CLUE_UNDECIDED;
+  }
+  for (int k = m->count - 1; k > 0; k--) {
+    int swap = rng_int(random, k + 1);
+    int tmp = m->order[k];
+    m->order[k] = m->order[swap];
+    m->order[swap] = tmp;
+  }
+
+  minimize_worker *workers =
+      arena_alloc(scratch, m->threads * sizeof(minimize_worker));
+  pthread_t *handles = arena_alloc(scratch, m->threads * sizeof(pthread_t));
+
+  if (m->threads > 1) {
+    pthread_barrier_init(&m->start, NULL, m->threads);
+    pthread_barrier_init(&m->done, NULL, m->threads);
+  }
+  for (int t = 0; t < m->threads; t++) {
+    workers[t].m = m;
+    if (t > 0) {
+      pthread_create(&handles[t], NULL, minimize_thread, &workers[t]);
+    }
+  }
+  load_clues(&workers[0]);
+
+  int first = 0;
+  while (first < m->count) {
+    first = run_window(m, workers, first);
+  }
+
+  if (m->threads > 1) {
+    m->finished = 1;
+    pthread_barrier_wait(&m->start);
+    for (int t = 1; t < m->threads; t++) {
+      pthread_join(handles[t], NULL);
+    }
+    pthread_barrier_destroy(&m->start);
+    pthread_barrier_destroy(&m->done);
+  }
+
+  int clues = 0;
+  *puzzle = *solution;
+  for (int k = 0; k < m->count; k++) {
+    if (m->decision[k] == CLUE_REMOVED) {
+      bitgrid_unset(puzzle, m->order[k] / cols, m->order[k] % cols);
+    } else {
+      clues++;
+    }
+  }
+
+  arena_scratch_done(scratch, &local, mark);
+  return clues;
+}
+
+/** Generates a minimal mask of a solution, with the generator of the calling
+thread.
+
+Copied parameters:
+ - int **solution: 2D array which contains a solution grid
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+
+Returns:
+ - int**: the resulting mask
+**/
+int **generate_minimal_mask(int **solution, int grid_size[2]) {
+  int **mask = create_grid(grid_size, INVALID_MASK);
+  bitgrid full, puzzle;
+
+  bitgrid_from_grid(&full, solution, grid_size);
+  bitgrid_minimal_puzzle(&full, &puzzle, rng_thread(), 1);
+
+  for (int i = 0; i < grid_size[0]; i++) {
+    for (int j = 0; j < grid_size[1]; j++) {
+      if (bitgrid_get(&puzzle, i, j) != -1) {
+        mask[i][j] = VALID_MASK;
+      }
+    }
+  }
+
+  return mask;
+}
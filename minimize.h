@@ -0,0 +1,11 @@
+#ifndef MINIMIZE_FILE
+#define MINIMIZE_FILE
+
+#include "bitboard.h"
+#include "rng.h"
+
+int bitgrid_minimal_puzzle(const bitgrid *solution, bitgrid *puzzle,
+                           rng *random, int threads);
+int **generate_minimal_mask(int **solution, int grid_size[2]);
+
+#endif
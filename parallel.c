@@ -0,0 +1,397 @@
+/**
+ * FILENAME: parallel.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Multi-threaded search for large grids, behind "--solve GRID
+ *        --threads T". The top of the search tree is split into tasks: at the
+ *        first SPLIT_DEPTH branchings, a worker keeps one value for itself and
+ *        pushes the other branch on its own deque. Idle workers steal the
+ *        oldest (shallowest, so largest) task of another worker, and sleep
+ *        while there is none. The first solution cancels every other task,
+ *        and solution counts are summed across workers. Like bitgrid_solve,
+ *        the solver restarts with twice the node budget, shared by the
+ *        workers, each time it runs out.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int bitgrid_solve_parallel(bitgrid *bg, int threads)
+ *        int bitgrid_count_solutions_parallel(const bitgrid *bg, int limit,
+ *                                             int threads)
+ *
+ **/
+
+#include "parallel.h"
+#include "arena.h"
+#include "backtracking.h"
+#include "propagation.h"
+#include "rng.h"
+#include "solver.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Branchings below which the second branch becomes a task of its own */
+#define SPLIT_DEPTH 10
+
+/* Node budget of each worker in the first run of the solver; as in
+bitgrid_solve, it doubles at each restart. The workers share the sum of their
+budgets, so that one that keeps finding work can use the budget of another */
+#define RESTART_NODES 2000
+
+typedef struct search_task {
+  bitgrid grid;
+  int depth;
+} search_task;
+
+/* Owner pushes and pops at the bottom, thieves take from the top */
+typedef struct task_deque {
+  pthread_mutex_t lock;
+  search_task *tasks;
+  int top;
+  int bottom;
+  int capacity;
+} task_deque;
+
+/* pending counts the tasks not finished yet, queued the ones waiting in a
+deque; idle workers sleep on task_ready until a task is queued or none is
+pending. When limited is set, budget holds the nodes left to the run */
+typedef struct parallel_search {
+  int threads;
+  int limit;
+  int limited;
+  int restart;
+  task_deque *deques;
+  atomic_int pending;
+  atomic_int queued;
+  atomic_int cancelled;
+  atomic_int count;
+  atomic_long budget;
+  atomic_int exhausted;
+  pthread_mutex_t idle_lock;
+  pthread_cond_t task_ready;
+  pthread_mutex_t result_lock;
+  bitgrid result;
+} parallel_search;
+
+typedef struct worker_args {
+  parallel_search *ps;
+  int index;
+  rng random;
+  solver_state state;
+} worker_args;
+
+/* Pushes a task at the bottom of a deque
+Modified parameter :
+-task_deque *dq : the deque of the calling worker
+Copied parameter :
+-const search_task *task : the task to copy in
+*/
+static void deque_push(task_deque *dq, const search_task *task) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->bottom == dq->capacity) {
+    int used = dq->bottom - dq->top;
+    if (dq->top > 0 && used < dq->capacity / 2) {
+      for (int k = 0; k < used; k++) {
+        dq->tasks[k] = dq->tasks[dq->top + k];
+      }
+    } else {
+      dq->capacity *= 2;
+      dq->tasks = realloc(dq->tasks, dq->capacity * sizeof(search_task));
+      for (int k = 0; k < used; k++) {
+        dq->tasks[k] = dq->tasks[dq->top + k];
+      }
+    }
+    dq->top = 0;
+    dq->bottom = used;
+  }
+  dq->tasks[dq->bottom++] = *task;
+  pthread_mutex_unlock(&dq->lock);
+}
+
+/* Takes a task from a deque, at the bottom for its owner and at the top for
+a thief
+Modified parameters :
+-task_deque *dq : the deque
+-search_task *task : receives the task
+Copied parameter :
+-int steal : whether the caller is a thief
+Return : int, 0 if the deque was empty
+*/
+static int deque_take(task_deque *dq, search_task *task, int steal) {
+  int found = 0;
+
+  pthread_mutex_lock(&dq->lock);
+  if (dq->bottom > dq->top) {
+    *task = steal ? dq->tasks[dq->top++] : dq->tasks[--dq->bottom];
+    found = 1;
+  }
+  pthread_mutex_unlock(&dq->lock);
+
+  return found;
+}
+
+/* Queues a task on the deque of a worker and wakes an idle worker
+Modified parameter :
+-parallel_search *ps : the search
+Copied parameters :
+-int index : the worker owning the deque
+-const search_task *task : the task
+*/
+static void queue_task(parallel_search *ps, int index,
+                       const search_task *task) {
+  atomic_fetch_add(&ps->pending, 1);
+  deque_push(&ps->deques[index], task);
+  atomic_fetch_add(&ps->queued, 1);
+
+  pthread_mutex_lock(&ps->idle_lock);
+  pthread_cond_signal(&ps->task_ready);
+  pthread_mutex_unlock(&ps->idle_lock);
+}
+
+/* Marks a task as finished, waking every idle worker after the last one
+Modified parameter :
+-parallel_search *ps : the search
+*/
+static void finish_task(parallel_search *ps) {
+  if (atomic_fetch_sub(&ps->pending, 1) == 1) {
+    pthread_mutex_lock(&ps->idle_lock);
+    pthread_cond_broadcast(&ps->task_ready);
+    pthread_mutex_unlock(&ps->idle_lock);
+  }
+}
+
+/* Depth-first search of one task. Near the root, the second value of each
+branching is pushed as a new task instead of being explored here
+Modified parameters :
+-worker_args *w : the worker running the task
+-solver_state *s : the search state
+Copied parameter :
+-int depth : number of branchings above this node
+Return : int, 1 once the search must stop (solution or limit reached)
+*/
+static int parallel_dfs(worker_args *w, solver_state *s, int depth) {
+  parallel_search *ps = w->ps;
+
+  if (atomic_load_explicit(&ps->cancelled, memory_order_relaxed)) {
+    return 1;
+  }
+  if (ps->limited && atomic_fetch_sub(&ps->budget, 1) <= 0) {
+    atomic_store(&ps->exhausted, 1);
+    atomic_store(&ps->cancelled, 1);
+    return 1;
+  }
+  STATS_INC(nodes);
+  STATS_MAX(max_depth, depth);
+  if (!propagate(s, RULES_ALL) || !probe(s, RULES_ALL)) {
+    return 0;
+  }
+
+  int next[2];
+  int first = search_branch(s, &w->random, next);
+  if (first == -1) {
+    if (atomic_fetch_add(&ps->count, 1) + 1 >= ps->limit) {
+      pthread_mutex_lock(&ps->result_lock);
+      if (!atomic_load(&ps->cancelled)) {
+        ps->result = s->grid;
+        atomic_store(&ps->cancelled, 1);
+      }
+      pthread_mutex_unlock(&ps->result_lock);
+      return 1;
+    }
+    return 0;
+  }
+
+  if (depth < SPLIT_DEPTH) {
+    search_task task;
+    task.grid = s->grid;
+    task.depth = depth + 1;
+    bitgrid_set(&task.grid, next[0], next[1], 1 - first);
+    queue_task(ps, w->index, &task);
+
+    int mark = s->trail_len;
+    int stop = solver_assign(s, next[0], next[1], first) &&
+               parallel_dfs(w, s, depth + 1);
+    solver_undo(s, mark);
+    return stop;
+  }
+
+  for (int i = 0, val = first; i < 2; i++, val = 1 - val) {
+    int mark = s->trail_len;
+    int stop = solver_assign(s, next[0], next[1], val) &&
+               parallel_dfs(w, s, depth + 1);
+    solver_undo(s, mark);
+    if (stop) {
+      return 1;
+    }
+    STATS_INC(backtracks);
+  }
+
+  return 0;
+}
+
+/* Worker thread: runs its own tasks, then steals, until no task is left;
+sleeps while every queued task is taken but some are still running, since
+they may queue more
+Modified parameter :
+-void *arg : a worker_args
+Return : NULL
+*/
+static void *parallel_worker(void *arg) {
+  worker_args *w = arg;
+  parallel_search *ps = w->ps;
+  search_task task;
+
+  rng_init(&w->random, ((uint64_t)ps->restart << 16) + w->index);
+  for (;;) {
+    int found = deque_take(&ps->deques[w->index], &task, 0);
+    for (int k = 1; k < ps->threads && !found; k++) {
+      found = deque_take(&ps->deques[(w->index + k) % ps->threads], &task, 1);
+    }
+
+    if (!found) {
+      pthread_mutex_lock(&ps->idle_lock);
+      while (atomic_load(&ps->queued) == 0 && atomic_load(&ps->pending) > 0) {
+        pthread_cond_wait(&ps->task_ready, &ps->idle_lock);
+      }
+      int done = atomic_load(&ps->pending) == 0;
+      pthread_mutex_unlock(&ps->idle_lock);
+      if (done) {
+        break;
+      }
+      continue;
+    }
+
+    atomic_fetch_sub(&ps->queued, 1);
+    if (!atomic_load(&ps->cancelled) && solver_load(&w->state, &task.grid)) {
+      parallel_dfs(w, &w->state, task.depth);
+    }
+    finish_task(ps);
+  }
+
+  stats_flush();
+  return NULL;
+}
+
+/* Runs a parallel search from a packed grid
+Modified parameter :
+-parallel_search *ps : the search, with threads and limit set
+Copied parameters :
+-const bitgrid *bg : the starting grid
+-long max_nodes : the nodes after which the search gives up, -1 for no limit
+*/
+static void run_parallel_search(parallel_search *ps, const bitgrid *bg,
+                                long max_nodes) {
+  arena local;
+  size_t mark;
+  arena *scratch = arena_scratch(
+      &local,
+      ps->threads *
+              (sizeof(pthread_t) + sizeof(worker_args) + sizeof(task_deque)) +
+          3 * ARENA_ALIGN,
+      &mark);
+  if (!scratch) {
+    fprintf(stderr, "Not enough memory for %d solver threads.\n", ps->threads);
+    exit(EXIT_FAILURE);
+  }
+  pthread_t *threads = arena_alloc(scratch, ps->threads * sizeof(pthread_t));
+  worker_args *workers =
+      arena_alloc(scratch, ps->threads * sizeof(worker_args));
+  search_task root = {*bg, 0};
+
+  ps->deques = arena_alloc(scratch, ps->threads * sizeof(task_deque));
+  atomic_init(&ps->pending, 0);
+  atomic_init(&ps->queued, 0);
+  atomic_init(&ps->cancelled, 0);
+  atomic_init(&ps->count, 0);
+  ps->limited = max_nodes >= 0;
+  atomic_init(&ps->budget, max_nodes);
+  atomic_init(&ps->exhausted, 0);
+  pthread_mutex_init(&ps->idle_lock, NULL);
+  pthread_cond_init(&ps->task_ready, NULL);
+  pthread_mutex_init(&ps->result_lock, NULL);
+
+  for (int t = 0; t < ps->threads; t++) {
+    pthread_mutex_init(&ps->deques[t].lock, NULL);
+    ps->deques[t].capacity = 4 * SPLIT_DEPTH;
+    ps->deques[t].tasks = malloc(ps->deques[t].capacity * sizeof(search_task));
+    ps->deques[t].top = 0;
+    ps->deques[t].bottom = 0;
+  }
+  queue_task(ps, 0, &root);
+
+  for (int t = 0; t < ps->threads; t++) {
+    workers[t].ps = ps;
+    workers[t].index = t;
+    pthread_create(&threads[t], NULL, parallel_worker, &workers[t]);
+  }
+  for (int t = 0; t < ps->threads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  for (int t = 0; t < ps->threads; t++) {
+    pthread_mutex_destroy(&ps->deques[t].lock);
+    free(ps->deques[t].tasks);
+  }
+  pthread_mutex_destroy(&ps->result_lock);
+  pthread_cond_destroy(&ps->task_ready);
+  pthread_mutex_destroy(&ps->idle_lock);
+  arena_scratch_done(scratch, &local, mark);
+}
+
+/* Solves a packed grid with several threads. The search restarts with twice
+the node budget each time it runs out, with new random tie-breaks, and a run
+that ends within its budget has proven there is no solution
+Modified parameter :
+-bitgrid *bg : the packed grid, filled in place
+Copied parameter :
+-int threads : the number of worker threads
+Return : int, whether a solution was found
+*/
+int bitgrid_solve_parallel(bitgrid *bg, int threads) {
+  if (threads <= 1) {
+    return bitgrid_solve(bg);
+  }
+
+  parallel_search ps;
+  ps.threads = threads;
+  ps.limit = 1;
+  ps.restart = 0;
+  for (long max_nodes = RESTART_NODES;; max_nodes *= 2) {
+    run_parallel_search(&ps, bg, max_nodes * threads);
+    if (atomic_load(&ps.count) > 0) {
+      *bg = ps.result;
+      return 1;
+    }
+    if (!atomic_load(&ps.exhausted)) {
+      return 0;
+    }
+    ps.restart++;
+  }
+}
+
+/* Counts the solutions of a packed grid with several threads, up to limit
+Copied parameters :
+-const bitgrid *bg : the packed grid
+-int limit : the search stops once limit solutions are found
+-int threads : the number of worker threads
+Return : int, the number of solutions found (at most limit)
+*/
+int bitgrid_count_solutions_parallel(const bitgrid *bg, int limit,
+                                     int threads) {
+  if (threads <= 1) {
+    return bitgrid_count_solutions(bg, limit);
+  }
+
+  parallel_search ps;
+  ps.threads = threads;
+  ps.limit = limit;
+  ps.restart = 0;
+  run_parallel_search(&ps, bg, -1);
+
+  int count = atomic_load(&ps.count);
+  return count < limit ? count : limit;
+}
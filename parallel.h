@@ -0,0 +1,10 @@
+#ifndef PARALLEL_FILE
+#define PARALLEL_FILE
+
+#include "bitboard.h"
+
+int bitgrid_solve_parallel(bitgrid *bg, int threads);
+int bitgrid_count_solutions_parallel(const bitgrid *bg, int limit,
+                                     int threads);
+
+#endif
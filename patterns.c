@@ -0,0 +1,322 @@
+/**
+ * FILENAME: patterns.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Row-pattern solver: the valid lines of a size are enumerated once and
+ *        cached, then grids are solved by choosing whole rows from that table.
+ *
+ * PUBLIC FUNCTIONS:
+ *        const line_table *get_line_table(int line_size)
+ *        int bitgrid_solve_rows(bitgrid *bg, rng *random)
+ *
+ **/
+
+#include "patterns.h"
+#include "propagation.h"
+#include "rng.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Nodes per row allowed to a random search before it restarts */
+#define RESTART_NODES 4
+
+/* Restarts of a random search before it leaves the grid to the cell search,
+far above what a valid shape needs (a dozen at most for 12x12) */
+#define MAX_RESTARTS 1000
+
+static line_table tables[PATTERN_MAX_SIZE / 2 + 1];
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Enumerates the valid lines that start with the pos first cells of line
+Modified parameter :
+-line_table *table : receives the lines (lines may be NULL to only count them)
+Copied parameters :
+-line_t line : the cells already chosen
+-int pos : number of cells already chosen
+-int ones : number of ones among them
+*/
+static void enumerate_lines(line_table *table, line_t line, int pos, int ones) {
+  int half = table->size / 2;
+
+  if (pos == table->size) {
+    if (table->lines) {
+      table->lines[table->count] = line;
+    }
+    table->count++;
+    return;
+  }
+
+  for (int value = 0; value < 2; value++) {
+    int count = value ? ones + 1 : pos + 1 - ones;
+    if (count > half) {
+      continue;
+    }
+    if (pos >= 2 && (int)((line >> (pos - 1)) & 1) == value &&
+        (int)((line >> (pos - 2)) & 1) == value) {
+      continue;
+    }
+    enumerate_lines(table, line | ((line_t)value << pos), pos + 1,
+                    ones + value);
+  }
+}
+
+/* Gets the table of valid lines of a size, building it on first use
+Copied parameter :
+-int line_size : the size of the lines
+Return : const line_table*, NULL if the size is odd or above PATTERN_MAX_SIZE
+*/
+const line_table *get_line_table(int line_size) {
+  if (line_size < 2 || line_size % 2 || line_size > PATTERN_MAX_SIZE) {
+    return NULL;
+  }
+
+  line_table *table = &tables[line_size / 2];
+
+  pthread_mutex_lock(&tables_lock);
+  if (!table->lines) {
+    line_table counter = {line_size, 0, NULL};
+    enumerate_lines(&counter, 0, 0, 0);
+
+    table->size = line_size;
+    table->lines = malloc(counter.count * sizeof(line_t));
+    table->count = 0;
+    enumerate_lines(table, 0, 0, 0);
+  }
+  pthread_mutex_unlock(&tables_lock);
+
+  return table;
+}
+
+typedef struct row_search {
+  const line_table *table;
+  const bitgrid *fixed;
+  rng *random;
+  int budget;
+  line_t chosen[MAX_GRID_SIZE];
+  /* ones[r][j] is the number of ones of column j in the r first rows */
+  unsigned char ones[MAX_GRID_SIZE + 1][MAX_GRID_SIZE];
+  /* fixed_below[r][j][v] is the number of fixed cells of value v in column j
+  from row r down */
+  unsigned char fixed_below[MAX_GRID_SIZE + 1][MAX_GRID_SIZE][2];
+} row_search;
+
+/* Whether a column can still be completed once value is appended to it:
+the missing values of each kind must fit around the other kind without
+making a triple
+Copied parameters :
+-int need_value, int need_other : values of each kind still missing after
+ the append
+-int run : length of the run of value that ends the column after the append
+Return : int
+*/
+static int column_completable(int need_value, int need_other, int run) {
+  if (need_value < 0 || need_other < 0) {
+    return 0;
+  }
+  return need_value <= 2 * need_other + (2 - run) &&
+         need_other <= 2 * (need_value + 1);
+}
+
+/* Computes, for row r, the columns that can no longer take a 1 (forbid[1])
+or a 0 (forbid[0]) given the rows chosen above and the fixed cells below
+Copied parameters :
+-const row_search *rs : the search
+-int r : the row about to be chosen
+Modified parameter :
+-line_t forbid[2] : receives the two masks
+*/
+static void forbidden_columns(const row_search *rs, int r, line_t forbid[2]) {
+  int rows = rs->fixed->size[0];
+  int half = rows / 2;
+
+  forbid[0] = 0;
+  forbid[1] = 0;
+  if (r + 1 < rows) {
+    line_t next_filled = rs->fixed->row_filled[r + 1];
+    line_t next_value = rs->fixed->row_value[r + 1];
+    line_t after_filled = r + 2 < rows ? rs->fixed->row_filled[r + 2] : 0;
+    line_t after_value = r + 2 < rows ? rs->fixed->row_value[r + 2] : 0;
+    line_t prev_value = r >= 1 ? rs->chosen[r - 1] : 0;
+    line_t prev_filled = r >= 1 ? ~(line_t)0 : 0;
+
+    forbid[1] |= next_filled & next_value &
+                 ((prev_filled & prev_value) | (after_filled & after_value));
+    forbid[0] |= next_filled & ~next_value &
+                 ((prev_filled & ~prev_value) | (after_filled & ~after_value));
+  }
+
+  for (int j = 0; j < rs->fixed->size[1]; j++) {
+    int ones = rs->ones[r][j];
+    int zeros = r - ones;
+
+    for (int value = 0; value < 2; value++) {
+      int run = 1;
+      if (r >= 1 && (int)((rs->chosen[r - 1] >> j) & 1) == value) {
+        run = 2;
+        if (r >= 2 && (int)((rs->chosen[r - 2] >> j) & 1) == value) {
+          run = 3;
+        }
+      }
+
+      int need_ones = half - ones - value;
+      int need_zeros = half - zeros - (1 - value);
+      int completable =
+          run < 3 && need_ones >= rs->fixed_below[r + 1][j][1] &&
+          need_zeros >= rs->fixed_below[r + 1][j][0] &&
+          (value ? column_completable(need_ones, need_zeros, run)
+                 : column_completable(need_zeros, need_ones, run));
+      if (!completable) {
+        forbid[value] |= (line_t)1 << j;
+      }
+    }
+  }
+}
+
+/* Whether all the columns of a completed grid differ: columns j and j + shift
+are equal when no row differs on them, i.e. when bit j of the OR of
+row ^ (row >> shift) is not set
+Copied parameter :
+-const row_search *rs : the search with all rows chosen
+Return : int
+*/
+static int columns_unique(const row_search *rs) {
+  int rows = rs->fixed->size[0];
+  int cols = rs->fixed->size[1];
+
+  for (int shift = 1; shift < cols; shift++) {
+    line_t differ = 0;
+    for (int r = 0; r < rows; r++) {
+      differ |= rs->chosen[r] ^ (rs->chosen[r] >> shift);
+    }
+    if (~differ & line_mask(cols - shift)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Chooses row r and the following ones
+Modified parameter :
+-row_search *rs : the search
+Copied parameter :
+-int r : the row to choose
+Return : int, 1 once every row is chosen
+*/
+static int search_rows(row_search *rs, int r) {
+  if (r == rs->fixed->size[0]) {
+    return columns_unique(rs);
+  }
+
+  if (rs->budget == 0) {
+    return 0;
+  }
+  rs->budget--;
+  STATS_INC(nodes);
+
+  /* Column-prefix compatibility: which columns can no longer take a 1 (or a
+  0) because of their quota or of the rows above */
+  line_t forbid[2];
+  forbidden_columns(rs, r, forbid);
+
+  line_t fixed_filled = rs->fixed->row_filled[r];
+  line_t fixed_value = rs->fixed->row_value[r];
+  int count = rs->table->count;
+  int start = rs->random ? rng_int(rs->random, count) : 0;
+
+  for (int k = 0; k < count; k++) {
+    int idx = start + k < count ? start + k : start + k - count;
+    line_t line = rs->table->lines[idx];
+
+    if (((line ^ fixed_value) & fixed_filled) || (line & forbid[1]) ||
+        (~line & forbid[0])) {
+      continue;
+    }
+
+    int used = 0;
+    for (int prev = 0; prev < r && !used; prev++) {
+      used = rs->chosen[prev] == line;
+    }
+    if (used) {
+      continue;
+    }
+
+    for (int j = 0; j < rs->fixed->size[1]; j++) {
+      rs->ones[r + 1][j] = rs->ones[r][j] + ((line >> j) & 1);
+    }
+    rs->chosen[r] = line;
+
+    STATS_DESCEND();
+    int found = search_rows(rs, r + 1);
+    STATS_ASCEND();
+    if (found) {
+      return 1;
+    }
+    STATS_INC(backtracks);
+  }
+
+  return 0;
+}
+
+/* Solves a packed grid by choosing whole rows from the table of valid lines,
+filtered by the fixed cells (after propagation) and by the columns built so
+far
+Modified parameters :
+-bitgrid *bg : the packed grid, filled in place
+-rng *random : draws the order in which the rows are tried (for generation),
+ NULL to try them in increasing order
+Return : int, 1 if solved, 0 if there is no solution, -1 if the size has no
+table or if the random search gave up
+*/
+int bitgrid_solve_rows(bitgrid *bg, rng *random) {
+  const line_table *table = get_line_table(bg->size[1]);
+  if (!table || bg->size[0] % 2) {
+    return -1;
+  }
+
+  /* Cells forced by the fixed ones are worth knowing before choosing rows:
+  the row filter only sees the fixed cells of the rows below through the
+  column counts */
+  solver_state s;
+  if (!solver_load(&s, bg) || !propagate(&s, RULES_ALL)) {
+    return 0;
+  }
+
+  row_search rs;
+  rs.table = table;
+  rs.fixed = &s.grid;
+  rs.random = random;
+  for (int j = 0; j < bg->size[1]; j++) {
+    rs.ones[0][j] = 0;
+    rs.fixed_below[bg->size[0]][j][0] = 0;
+    rs.fixed_below[bg->size[0]][j][1] = 0;
+    for (int i = bg->size[0] - 1; i >= 0; i--) {
+      int value = bitgrid_get(&s.grid, i, j);
+      rs.fixed_below[i][j][0] = rs.fixed_below[i + 1][j][0] + (value == 0);
+      rs.fixed_below[i][j][1] = rs.fixed_below[i + 1][j][1] + (value == 1);
+    }
+  }
+
+  /* Chronological backtracking cannot escape two columns whose prefixes are
+  already equal and forced to end the same way, so a random search restarts
+  after a few dead ends instead of exhausting the bottom of the tree */
+  int found, restarts = 0;
+  do {
+    rs.budget = random ? RESTART_NODES * bg->size[0] : -1;
+    found = search_rows(&rs, 0);
+  } while (!found && random && rs.budget == 0 && ++restarts < MAX_RESTARTS);
+
+  if (!found) {
+    return random && rs.budget == 0 ? -1 : 0;
+  }
+
+  for (int i = 0; i < bg->size[0]; i++) {
+    for (int j = 0; j < bg->size[1]; j++) {
+      bitgrid_set(bg, i, j, (rs.chosen[i] >> j) & 1);
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,19 @@
+#ifndef PATTERNS_FILE
+#define PATTERNS_FILE
+
+#include "bitboard.h"
+#include "rng.h"
+
+#define PATTERN_MAX_SIZE 12
+
+/* Every valid complete line of a given size, in increasing order */
+typedef struct line_table {
+  int size;
+  int count;
+  line_t *lines;
+} line_table;
+
+const line_table *get_line_table(int line_size);
+int bitgrid_solve_rows(bitgrid *bg, rng *random);
+
+#endif
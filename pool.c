@@ -0,0 +1,331 @@
+/**
+ * FILENAME: pool.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Puzzle pools: producer threads generate puzzles of one size ahead of
+ *        time, so that asking for one is a copy out of a ring. A rated pool
+ *        keeps one ring per difficulty tier and makes puzzles easier with
+ *        clues of their solution when a ring of an easier tier needs them,
+ *        since the generator mostly gives hard puzzles on large grids. When
+ *        a ring is empty, the puzzle is made by the caller instead.
+ *
+ * PUBLIC FUNCTIONS:
+ *        void pool_start(puzzle_pool *pool, int grid_size[2], int capacity,
+ *                        int threads, int rated, uint64_t seed)
+ *        int pool_take(puzzle_pool *pool, int tier, pool_entry *entry)
+ *        void pool_read_counters(puzzle_pool *pool, int bucket,
+ *                                pool_counters *counters)
+ *        void pool_stop(puzzle_pool *pool)
+ *
+ **/
+
+#include "pool.h"
+#include "generator.h"
+#include "stats.h"
+
+#include <stdlib.h>
+
+/* Productions in a row missing a ring before it is no longer aimed at */
+#define POOL_GIVE_UP 32
+
+/* Puzzles a caller makes for an empty ring before giving up */
+#define POOL_MISS_TRIES 8
+
+/* Generates a puzzle and, in a rated pool, rates it and eases it down to the
+target tier when it is harder
+Copied parameters :
+-const puzzle_pool *pool : the pool
+-uint64_t seed : the seed of the puzzle
+-int target : the tier aimed at
+Modified parameter :
+-pool_entry *entry : receives the puzzle
+Return : int, 0 if no puzzle could be made
+*/
+static int make_entry(const puzzle_pool *pool, uint64_t seed, int target,
+                      pool_entry *entry) {
+  difficulty_report report;
+
+  entry->seed = seed;
+  entry->eased = 0;
+  entry->tier = 0;
+  entry->score = 0;
+  if (!generate_puzzle(seed, (int *)pool->grid_size, &entry->solution,
+                       &entry->puzzle)) {
+    return 0;
+  }
+  if (pool->buckets == 1) {
+    return 1;
+  }
+
+  if (!rate_puzzle(&entry->puzzle, &report)) {
+    return 0;
+  }
+  if (report.tier > target) {
+    entry->eased = ease_puzzle(&entry->puzzle, &entry->solution, target) > 0;
+    rate_puzzle(&entry->puzzle, &report);
+  }
+  entry->tier = report.tier;
+  entry->score = report.score;
+  return 1;
+}
+
+/* Puts a puzzle in the ring of its tier, unless the ring is full; the pool
+lock must be held
+Modified parameter :
+-puzzle_pool *pool : the pool
+Copied parameter :
+-const pool_entry *entry : the puzzle
+*/
+static void store_entry(puzzle_pool *pool, const pool_entry *entry) {
+  int b = entry->tier;
+
+  if (pool->ready[b] < pool->capacity) {
+    int slot = (pool->first[b] + pool->ready[b]) % pool->capacity;
+    pool->entries[b * pool->capacity + slot] = *entry;
+    pool->ready[b]++;
+  }
+}
+
+/* Takes the oldest puzzle of a non-empty ring; the pool lock must be held
+Modified parameters :
+-puzzle_pool *pool : the pool
+-pool_entry *entry : receives the puzzle
+Copied parameter :
+-int b : the ring
+*/
+static void pop_entry(puzzle_pool *pool, int b, pool_entry *entry) {
+  *entry = pool->entries[b * pool->capacity + pool->first[b]];
+  pool->first[b] = (pool->first[b] + 1) % pool->capacity;
+  pool->ready[b]--;
+  pthread_cond_signal(&pool->wanted);
+}
+
+/* Finds the ring the next production should aim at: the emptiest one that is
+neither full nor given up
+Copied parameter :
+-const puzzle_pool *pool : the pool
+Return : int, the ring, -1 if there is nothing to make
+*/
+static int neediest_bucket(const puzzle_pool *pool) {
+  int best = -1;
+
+  for (int b = 0; b < pool->buckets; b++) {
+    if (pool->ready[b] < pool->capacity &&
+        pool->failures[b] < POOL_GIVE_UP &&
+        (best < 0 || pool->ready[b] < pool->ready[best])) {
+      best = b;
+    }
+  }
+  return best;
+}
+
+/* Finds the ring holding the most puzzles
+Copied parameter :
+-const puzzle_pool *pool : the pool
+Return : int, the ring
+*/
+static int fullest_bucket(const puzzle_pool *pool) {
+  int best = 0;
+
+  for (int b = 1; b < pool->buckets; b++) {
+    if (pool->ready[b] > pool->ready[best]) {
+      best = b;
+    }
+  }
+  return best;
+}
+
+/* Producer thread: fills the rings until the pool stops, sleeping while
+there is nothing to make
+Modified parameter :
+-void *arg : the puzzle_pool
+Return : NULL
+*/
+static void *pool_producer(void *arg) {
+  puzzle_pool *pool = arg;
+  pool_entry entry;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    int target;
+    while (!pool->stopping && (target = neediest_bucket(pool)) < 0) {
+      pthread_cond_wait(&pool->wanted, &pool->lock);
+    }
+    if (pool->stopping) {
+      break;
+    }
+    uint64_t seed = rng_next(&pool->seeds);
+    pthread_mutex_unlock(&pool->lock);
+
+    int made = make_entry(pool, seed, target, &entry);
+
+    pthread_mutex_lock(&pool->lock);
+    if (made) {
+      store_entry(pool, &entry);
+    }
+    if (made && entry.tier == target) {
+      pool->failures[target] = 0;
+    } else {
+      pool->failures[target]++;
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  stats_flush();
+  return NULL;
+}
+
+/** Starts a pool and its producers, which begin filling it at once.
+
+Copied parameters:
+ - int grid_size[2]: contains the size of the grid in the X and Y dimension
+ - int capacity: the number of puzzles kept ready in each ring
+ - int threads: the number of producer threads
+ - int rated: whether to keep one ring per difficulty tier
+ - uint64_t seed: seed of the generator drawing the seeds of the puzzles
+
+Modified parameter:
+ - puzzle_pool *pool: the pool to start
+
+No return
+**/
+void pool_start(puzzle_pool *pool, int grid_size[2], int capacity,
+                int threads, int rated, uint64_t seed) {
+  pool->grid_size[0] = grid_size[0];
+  pool->grid_size[1] = grid_size[1];
+  pool->capacity = capacity < 1 ? 1 : capacity;
+  pool->buckets = rated ? TIER_COUNT : 1;
+  pool->entries =
+      malloc(pool->buckets * pool->capacity * sizeof(pool_entry));
+  for (int b = 0; b < TIER_COUNT; b++) {
+    pool->first[b] = 0;
+    pool->ready[b] = 0;
+    pool->failures[b] = 0;
+    pool->hits[b] = 0;
+    pool->misses[b] = 0;
+  }
+  rng_init(&pool->seeds, seed);
+  pool->stopping = 0;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wanted, NULL);
+
+  pool->threads = threads < 1 ? 1 : threads;
+  pool->producers = malloc(pool->threads * sizeof(pthread_t));
+  for (int t = 0; t < pool->threads; t++) {
+    pthread_create(&pool->producers[t], NULL, pool_producer, pool);
+  }
+}
+
+/** Takes a puzzle out of a pool. When its ring is empty, the puzzle is made
+by the calling thread, and the puzzles it makes for other tiers on the way are
+kept in their rings.
+
+Copied parameter:
+ - int tier: one of the TIER_* values, or POOL_ANY (always POOL_ANY or 0 for
+   a pool that is not rated)
+
+Modified parameters:
+ - puzzle_pool *pool: the pool
+ - pool_entry *entry: receives the puzzle
+
+Returns:
+ - int: 1 if the puzzle was ready, 0 if it was made for this call, -1 if no
+   puzzle of that tier could be made
+**/
+int pool_take(puzzle_pool *pool, int tier, pool_entry *entry) {
+  int any = tier == POOL_ANY || pool->buckets == 1;
+  int target = pool->buckets == 1 ? 0 : any ? TIER_EXPERT : tier;
+
+  pthread_mutex_lock(&pool->lock);
+  int b = any ? fullest_bucket(pool) : tier;
+  if (pool->ready[b] > 0) {
+    pop_entry(pool, b, entry);
+    pool->hits[b]++;
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+  }
+
+  /* Somebody wants this ring: the producers aim at it again */
+  if (!any) {
+    pool->failures[tier] = 0;
+    pthread_cond_broadcast(&pool->wanted);
+  }
+
+  for (int attempt = 0; attempt < POOL_MISS_TRIES; attempt++) {
+    uint64_t seed = rng_next(&pool->seeds);
+    pthread_mutex_unlock(&pool->lock);
+
+    int made = make_entry(pool, seed, target, entry);
+
+    pthread_mutex_lock(&pool->lock);
+    if (made && (any || entry->tier == tier)) {
+      pool->misses[entry->tier]++;
+      pthread_mutex_unlock(&pool->lock);
+      return 0;
+    }
+    if (made) {
+      store_entry(pool, entry);
+    }
+    /* A producer may have been quicker */
+    if (pool->ready[b] > 0) {
+      pop_entry(pool, b, entry);
+      pool->misses[b]++;
+      pthread_mutex_unlock(&pool->lock);
+      return 0;
+    }
+  }
+
+  pool->misses[b]++;
+  if (!any) {
+    pool->failures[tier] = POOL_GIVE_UP;
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return -1;
+}
+
+/** Reads the counters of one ring of a pool.
+
+Copied parameter:
+ - int bucket: the ring, a TIER_* value for a rated pool, 0 otherwise
+
+Modified parameters:
+ - puzzle_pool *pool: the pool
+ - pool_counters *counters: receives the counters
+
+No return
+**/
+void pool_read_counters(puzzle_pool *pool, int bucket,
+                        pool_counters *counters) {
+  pthread_mutex_lock(&pool->lock);
+  counters->ready = pool->ready[bucket];
+  counters->capacity = pool->capacity;
+  counters->hits = pool->hits[bucket];
+  counters->misses = pool->misses[bucket];
+  counters->given_up = pool->failures[bucket] >= POOL_GIVE_UP;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/** Stops the producers of a pool, once they finish the puzzle they are
+making, and frees the pool.
+
+Modified parameter:
+ - puzzle_pool *pool: the pool
+
+No return
+**/
+void pool_stop(puzzle_pool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->wanted);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int t = 0; t < pool->threads; t++) {
+    pthread_join(pool->producers[t], NULL);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wanted);
+  free(pool->producers);
+  free(pool->entries);
+}
@@ -0,0 +1,65 @@
+#ifndef POOL_FILE
+#define POOL_FILE
+
+#include "bitboard.h"
+#include "difficulty.h"
+#include "rng.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Tier asked for when any puzzle will do */
+#define POOL_ANY -1
+
+/* A ready puzzle. Its seed gives the puzzle ID, unless the puzzle was eased:
+then it holds clues that generate_puzzle does not give back. The tier and
+score are only set by rated pools (tier 0 otherwise). */
+typedef struct pool_entry {
+  uint64_t seed;
+  int eased;
+  int tier;
+  int score;
+  bitgrid solution;
+  bitgrid puzzle;
+} pool_entry;
+
+/* Puzzles of one size made ahead of time by producer threads: a ring of
+capacity entries per tier when the pool is rated, a single ring otherwise.
+Each production aims at the emptiest ring; a ring that keeps being missed
+(failures reaching POOL_GIVE_UP, like hard puzzles on 4x4 grids) is no longer
+aimed at until somebody asks for it. */
+typedef struct puzzle_pool {
+  int grid_size[2];
+  int capacity;
+  int buckets;
+  pool_entry *entries;
+  int first[TIER_COUNT];
+  int ready[TIER_COUNT];
+  int failures[TIER_COUNT];
+  long hits[TIER_COUNT];
+  long misses[TIER_COUNT];
+  rng seeds;
+  int threads;
+  pthread_t *producers;
+  int stopping;
+  pthread_mutex_t lock;
+  pthread_cond_t wanted;
+} puzzle_pool;
+
+/* Counters of one ring of a pool */
+typedef struct pool_counters {
+  int ready;
+  int capacity;
+  long hits;
+  long misses;
+  int given_up;
+} pool_counters;
+
+void pool_start(puzzle_pool *pool, int grid_size[2], int capacity,
+                int threads, int rated, uint64_t seed);
+int pool_take(puzzle_pool *pool, int tier, pool_entry *entry);
+void pool_read_counters(puzzle_pool *pool, int bucket,
+                        pool_counters *counters);
+void pool_stop(puzzle_pool *pool);
+
+#endif
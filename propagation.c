@@ -0,0 +1,259 @@
+/**
+ * FILENAME: propagation.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Deduction rules of the Takuzu, applied to the dirty lines of a search
+ *        state until nothing more can be forced, and probing of single cells
+ *        for the puzzles these rules cannot finish.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int line_deductions(line_t filled, line_t value, const int count[2],
+ *                            int line_size, completion_kernel kernel,
+ *                            const line_set *completed, int rules,
+ *                            line_t forced[2])
+ *        int propagate(solver_state *s, int rules)
+ *        int probe(solver_state *s, int rules)
+ *
+ **/
+
+#include "propagation.h"
+#include "stats.h"
+
+/* Cells forced to the opposite of a packed set of equal values: both
+neighbours of a pair (xx -> yxxy) and the middle of a gap (x.x -> xyx)
+Copied parameters :
+-line_t same : bit i set when cell i holds the value
+-int rules : RULE_PAIR and/or RULE_GAP
+Return : line_t, the cells that must hold the other value
+*/
+static line_t forced_by_neighbours(line_t same, int rules) {
+  line_t forced = 0;
+
+  if (rules & RULE_PAIR) {
+    line_t pairs = same & (same >> 1);
+    forced |= (pairs >> 1) | (pairs << 2);
+  }
+
+  if (rules & RULE_GAP) {
+    line_t gaps = same & (same >> 2);
+    forced |= gaps << 1;
+  }
+
+  return forced;
+}
+
+/* Computes the cells of a line forced by the selected rules
+Copied parameters :
+-line_t filled, line_t value : the packed line
+-const int count[2] : number of zeros and ones in the line
+-int line_size : the number of cells in the line
+-completion_kernel kernel : the line analysis kernel of that size
+-const line_set *completed : the completed lines of the same direction
+-int rules : the rules to apply (RULE_* flags)
+Modified parameter :
+-line_t forced[2] : receives the empty cells forced to 0 and to 1
+Return : int, 0 if a cell is forced to both values
+*/
+int line_deductions(line_t filled, line_t value, const int count[2],
+                    int line_size, completion_kernel kernel,
+                    const line_set *completed, int rules, line_t forced[2]) {
+  line_t empty = ~filled & line_mask(line_size);
+
+  forced[0] = forced_by_neighbours(filled & value, rules);
+  forced[1] = forced_by_neighbours(filled & ~value, rules);
+
+  if (rules & RULE_QUOTA) {
+    if (count[1] == line_size / 2) {
+      forced[0] |= empty;
+    }
+    if (count[0] == line_size / 2) {
+      forced[1] |= empty;
+    }
+  }
+
+  /* Two empty cells left, one for each value: the line can only be
+  completed in two ways, and a way that is already a completed line is
+  forbidden */
+  if ((rules & RULE_DUPLICATE) && count[0] == line_size / 2 - 1 &&
+      count[1] == line_size / 2 - 1) {
+    line_t low = empty & -empty;
+    line_t high = empty & ~low;
+    if (line_set_contains(completed, value | high)) {
+      forced[0] |= high;
+      forced[1] |= low;
+    } else if (line_set_contains(completed, value | low)) {
+      forced[0] |= low;
+      forced[1] |= high;
+    }
+  }
+
+  if (rules & RULE_LINE) {
+    line_t possible[2];
+    kernel(filled, value, line_size, possible);
+    forced[0] |= ~possible[1];
+    forced[1] |= ~possible[0];
+  }
+
+  forced[0] &= empty;
+  forced[1] &= empty;
+
+  return !(forced[0] & forced[1]);
+}
+
+/* Assigns the forced cells of a row (is_row) or a column
+Modified parameter :
+-solver_state *s : the search state
+Copied parameters :
+-int idx : index of the line
+-int is_row : whether the line is a row
+-line_t forced[2] : cells forced to 0 and to 1
+Return : int, 0 on conflict
+*/
+static int assign_forced(solver_state *s, int idx, int is_row,
+                         line_t forced[2]) {
+  for (int value = 0; value < 2; value++) {
+    line_t cells = forced[value];
+    while (cells) {
+      int k = __builtin_ctzll(cells);
+      int valid = is_row ? solver_assign(s, idx, k, value)
+                         : solver_assign(s, k, idx, value);
+      STATS_INC(propagations);
+      if (!valid) {
+        return 0;
+      }
+      cells &= cells - 1;
+    }
+  }
+  return 1;
+}
+
+/* Runs the selected rules on one row (is_row) or column and assigns what
+they force
+Modified parameter :
+-solver_state *s : the search state
+Copied parameters :
+-int idx : index of the line
+-int is_row : whether the line is a row
+-int rules : the rules to apply (RULE_* flags)
+Return : int, 0 on conflict
+*/
+static int deduce_line(solver_state *s, int idx, int is_row, int rules) {
+  bitgrid *bg = &s->grid;
+  line_t forced[2];
+  int valid;
+
+  if (is_row) {
+    valid = line_deductions(bg->row_filled[idx], bg->row_value[idx],
+                            s->row_count[idx], bg->size[1], s->row_kernel,
+                            &s->row_set, rules, forced);
+  } else {
+    valid = line_deductions(bg->col_filled[idx], bg->col_value[idx],
+                            s->col_count[idx], bg->size[0], s->col_kernel,
+                            &s->col_set, rules, forced);
+  }
+
+  return valid && assign_forced(s, idx, is_row, forced);
+}
+
+/* Applies the rules to the dirty lines until no line is dirty. The cheap
+rules run first; the full line analysis (RULE_LINE) only runs on a line
+changed since its last analysis once the cheap rules have nothing left to
+force. Cells are assigned through solver_assign and stay on the trail, so the
+caller undoes them like any other assignment
+Modified parameter :
+-solver_state *s : the search state
+Copied parameter :
+-int rules : the rules to apply (RULE_* flags)
+Return : int, 0 if a contradiction was found
+*/
+int propagate(solver_state *s, int rules) {
+  int cheap_rules = rules & ~RULE_LINE;
+
+  for (;;) {
+    while (s->dirty_rows || s->dirty_cols) {
+      while (s->dirty_rows) {
+        int i = __builtin_ctzll(s->dirty_rows);
+        s->dirty_rows &= s->dirty_rows - 1;
+        if (!deduce_line(s, i, 1, cheap_rules)) {
+          return 0;
+        }
+      }
+
+      while (s->dirty_cols) {
+        int j = __builtin_ctzll(s->dirty_cols);
+        s->dirty_cols &= s->dirty_cols - 1;
+        if (!deduce_line(s, j, 0, cheap_rules)) {
+          return 0;
+        }
+      }
+    }
+
+    if (!(rules & RULE_LINE)) {
+      return 1;
+    }
+
+    if (s->pending_rows) {
+      int i = __builtin_ctzll(s->pending_rows);
+      s->pending_rows &= s->pending_rows - 1;
+      if (!deduce_line(s, i, 1, RULE_LINE)) {
+        return 0;
+      }
+    } else if (s->pending_cols) {
+      int j = __builtin_ctzll(s->pending_cols);
+      s->pending_cols &= s->pending_cols - 1;
+      if (!deduce_line(s, j, 0, RULE_LINE)) {
+        return 0;
+      }
+    } else {
+      return 1;
+    }
+  }
+}
+
+/* Failed-literal probing: tries both values of every empty cell with
+propagation; when one of them leads to a contradiction, the other one is
+assigned. Runs until no probe forces anything
+Modified parameter :
+-solver_state *s : the search state, at a propagation fixpoint
+Copied parameter :
+-int rules : the rules used by the propagation of each probe
+Return : int, 0 if a contradiction was found
+*/
+int probe(solver_state *s, int rules) {
+  bitgrid *bg = &s->grid;
+  int changed = 1;
+
+  while (changed) {
+    changed = 0;
+    for (int i = 0; i < bg->size[0]; i++) {
+      line_t empty = ~bg->row_filled[i] & line_mask(bg->size[1]);
+
+      while (empty) {
+        int j = __builtin_ctzll(empty);
+        empty &= empty - 1;
+        if ((bg->row_filled[i] >> j) & 1) {
+          continue;
+        }
+
+        for (int value = 0; value < 2; value++) {
+          int mark = s->trail_len;
+          int consistent =
+              solver_assign(s, i, j, value) && propagate(s, rules);
+          solver_undo(s, mark);
+
+          if (!consistent) {
+            if (!solver_assign(s, i, j, 1 - value) || !propagate(s, rules)) {
+              return 0;
+            }
+            changed = 1;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  return 1;
+}
@@ -0,0 +1,20 @@
+#ifndef PROPAGATION_FILE
+#define PROPAGATION_FILE
+
+#include "solver.h"
+
+#define RULE_PAIR 1
+#define RULE_GAP 2
+#define RULE_QUOTA 4
+#define RULE_DUPLICATE 8
+#define RULE_LINE 16
+#define RULES_ALL                                                              \
+  (RULE_PAIR | RULE_GAP | RULE_QUOTA | RULE_DUPLICATE | RULE_LINE)
+
+int line_deductions(line_t filled, line_t value, const int count[2],
+                    int line_size, completion_kernel kernel,
+                    const line_set *completed, int rules, line_t forced[2]);
+int propagate(solver_state *s, int rules);
+int probe(solver_state *s, int rules);
+
+#endif
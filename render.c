@@ -0,0 +1,238 @@
+/**
+ * FILENAME: render.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Terminal rendering of game and mask grids. A frame is built in a
+ *        buffer allocated once for the size of the grid and written with a
+ *        single write call. In place mode keeps the grid at the top of the
+ *        screen (the rest of the screen is a scrolling region for the
+ *        prompts) and redraws only the cells that changed, with cursor
+ *        addressing.
+ *
+ * PUBLIC FUNCTIONS:
+ *        void renderer_init(renderer *r, int grid_size[2], int in_place)
+ *        void render_grid(renderer *r, int **grid)
+ *        void renderer_free(renderer *r)
+ *
+ **/
+
+#include "render.h"
+#include "constants.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/* Bytes of the widest cell (colour, three 3-byte squares, reset, border) */
+#define CELL_BYTES 32
+/* Lines below the grid kept for the prompts in place mode */
+#define PROMPT_LINES 12
+
+/* Screen line of the top border, the frame starting with an empty line and
+the column names */
+#define FIRST_LINE 3
+/* Screen column of the first cell, after the row number and the border */
+#define FIRST_COLUMN 7
+
+/* Appends a string to the frame
+Modified parameter :
+-renderer *r : the renderer
+Copied parameter :
+-const char *text : the string
+*/
+static void put(renderer *r, const char *text) {
+  size_t n = strlen(text);
+  memcpy(r->buf + r->len, text, n);
+  r->len += n;
+}
+
+/* Number of lines of a frame
+Copied parameter :
+-const int grid_size[2] : contains the size of the grid in the X and Y
+ dimension
+Return : int, the number of lines
+*/
+static int frame_lines(const int grid_size[2]) {
+  return 2 * grid_size[0] + 3;
+}
+
+/* Appends one cell, without its right border
+Modified parameter :
+-renderer *r : the renderer
+Copied parameter :
+-int value : the cell, 0, 1, -1 (empty), VALID_MASK or INVALID_MASK
+*/
+static void put_cell(renderer *r, int value) {
+  if (value == -1) {
+    put(r, "  *  ");
+  } else if (value == 1) {
+    put(r, YELLOW "  1  " RESET);
+  } else if (value == 0) {
+    put(r, GREEN "  0  " RESET);
+  } else if (value == VALID_MASK) {
+    put(r, GREEN " ■■■ " RESET);
+  } else {
+    put(r, "     ");
+  }
+}
+
+/* Appends a border line of the frame
+Modified parameter :
+-renderer *r : the renderer
+Copied parameters :
+-const char *left, const char *middle, const char *right : the joints
+*/
+static void put_border(renderer *r, const char *left, const char *middle,
+                       const char *right) {
+  put(r, left);
+  for (int j = 0; j < r->grid_size[1]; j++) {
+    put(r, "═════");
+    put(r, j == r->grid_size[1] - 1 ? right : middle);
+  }
+}
+
+/* Appends a whole frame, drawn like print_grid always did
+Modified parameter :
+-renderer *r : the renderer
+Copied parameter :
+-int **grid : the grid to draw
+*/
+static void put_frame(renderer *r, int **grid) {
+  char text[32];
+
+  put(r, "\n      ");
+  for (int j = 0; j < r->grid_size[1]; j++) {
+    char name[3];
+    column_name(j, name);
+    snprintf(text, sizeof(text), "  %-2s  ", name);
+    put(r, text);
+  }
+  put_border(r, "\n     ╔", "╦", "╗\n");
+
+  for (int i = 0; i < r->grid_size[0]; i++) {
+    snprintf(text, sizeof(text), "%02d   ║", i + 1);
+    put(r, text);
+    for (int j = 0; j < r->grid_size[1]; j++) {
+      put_cell(r, grid[i][j]);
+      put(r, "║");
+    }
+    if (i < r->grid_size[0] - 1) {
+      put_border(r, "\n     ║", "╬", "║");
+    }
+    put(r, "\n");
+  }
+
+  put_border(r, "     ╚", "╩", "╝\n");
+}
+
+/* Writes the frame to the standard output and empties the buffer. What
+printf still holds is flushed first so that the order of the output is kept
+Modified parameter :
+-renderer *r : the renderer
+*/
+static void flush_frame(renderer *r) {
+  size_t done = 0;
+
+  fflush(stdout);
+  while (done < r->len) {
+    ssize_t n = write(STDOUT_FILENO, r->buf + done, r->len - done);
+    if (n <= 0) {
+      break;
+    }
+    done += n;
+  }
+  r->len = 0;
+}
+
+/* Prepares a renderer for grids of one size
+Modified parameter :
+-renderer *r : the renderer
+Copied parameters :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+-int in_place : whether to redraw the changed cells in place; only used when
+ the output is a terminal with room for the grid and the prompts
+*/
+void renderer_init(renderer *r, int grid_size[2], int in_place) {
+  int cells = grid_size[0] * grid_size[1];
+  struct winsize window;
+
+  r->grid_size[0] = grid_size[0];
+  r->grid_size[1] = grid_size[1];
+  r->in_place =
+      in_place && isatty(STDOUT_FILENO) &&
+      ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 &&
+      window.ws_row >= frame_lines(grid_size) + PROMPT_LINES &&
+      window.ws_col >= FIRST_COLUMN + 6 * grid_size[1];
+  r->drawn = 0;
+  r->shown = malloc(cells * sizeof(int));
+  r->len = 0;
+
+  /* Every line of the frame holds at most one cell or border per column,
+  and a cell update at most a cursor move and a cell */
+  r->buf = malloc((size_t)(frame_lines(grid_size) + 1) *
+                      (grid_size[1] + 2) * CELL_BYTES +
+                  (size_t)cells * 2 * CELL_BYTES + 64);
+}
+
+/* Draws a grid: a whole frame, or only the cells that changed since the last
+frame in place mode
+Modified parameter :
+-renderer *r : the renderer
+Copied parameter :
+-int **grid : the grid to draw, of the size of the renderer
+*/
+void render_grid(renderer *r, int **grid) {
+  char text[32];
+
+  if (!r->in_place || !r->drawn) {
+    if (r->in_place) {
+      put(r, "\x1B[H\x1B[2J");
+    }
+    put_frame(r, grid);
+    if (r->in_place) {
+      /* The prompts scroll below the grid */
+      snprintf(text, sizeof(text), "\x1B[%d;r\x1B[%d;1H",
+               frame_lines(r->grid_size) + 1, frame_lines(r->grid_size) + 1);
+      put(r, text);
+    }
+  } else {
+    put(r, "\x1B" "7");
+    for (int i = 0; i < r->grid_size[0]; i++) {
+      for (int j = 0; j < r->grid_size[1]; j++) {
+        if (r->shown[i * r->grid_size[1] + j] != grid[i][j]) {
+          snprintf(text, sizeof(text), "\x1B[%d;%dH", FIRST_LINE + 2 * i + 1,
+                   FIRST_COLUMN + 6 * j);
+          put(r, text);
+          put_cell(r, grid[i][j]);
+        }
+      }
+    }
+    put(r, "\x1B" "8");
+  }
+
+  for (int i = 0; i < r->grid_size[0]; i++) {
+    for (int j = 0; j < r->grid_size[1]; j++) {
+      r->shown[i * r->grid_size[1] + j] = grid[i][j];
+    }
+  }
+  r->drawn = 1;
+  flush_frame(r);
+}
+
+/* Gives the whole screen back to the normal output and frees the renderer
+Modified parameter :
+-renderer *r : the renderer
+*/
+void renderer_free(renderer *r) {
+  if (r->in_place && r->drawn) {
+    put(r, "\x1B" "7\x1B[r\x1B" "8");
+    flush_frame(r);
+  }
+  free(r->shown);
+  free(r->buf);
+}
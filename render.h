@@ -0,0 +1,23 @@
+#ifndef RENDER_FILE
+#define RENDER_FILE
+
+#include <stddef.h>
+
+/* Draws grids with one write per frame. In place mode (on a terminal tall
+enough for the grid), the first frame is drawn at the top of the screen and the
+lines below it scroll on their own; later frames only move the cursor to the
+cells that changed and redraw them. */
+typedef struct renderer {
+  int grid_size[2];
+  int in_place;
+  int drawn;
+  int *shown;
+  char *buf;
+  size_t len;
+} renderer;
+
+void renderer_init(renderer *r, int grid_size[2], int in_place);
+void render_grid(renderer *r, int **grid);
+void renderer_free(renderer *r);
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * FILENAME: rng.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Random numbers for grid generation, with the xoshiro256** generator.
+ *        Generators are passed explicitly, so a puzzle can be made again from
+ *        its seed on any thread. The int grid functions, which take no
+ *        generator, draw from one owned by the calling thread.
+ *
+ * PUBLIC FUNCTIONS:
+ *        void rng_init(rng *r, uint64_t seed)
+ *        uint64_t rng_next(rng *r)
+ *        int rng_int(rng *r, int bound)
+ *        rng *rng_thread(void)
+ *        void rng_seed(uint64_t seed)
+ *        uint64_t rng_random_seed(void)
+ *        uint64_t rng_derive(uint64_t seed, uint64_t k)
+ *
+ **/
+
+#include "rng.h"
+
+#include <stdio.h>
+#include <sys/random.h>
+#include <time.h>
+
+static _Thread_local rng thread_rng;
+static _Thread_local int thread_rng_ready = 0;
+
+/* One splitmix64 step, used to spread a seed over the generator state
+Modified parameter :
+-uint64_t *x : the splitmix64 state
+Return : uint64_t, the next output
+*/
+static uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/** Seeds a generator.
+
+Copied parameter:
+ - uint64_t seed: any value, 0 included; close seeds give unrelated streams
+
+Modified parameter:
+ - rng *r: the generator
+
+No return
+**/
+void rng_init(rng *r, uint64_t seed) {
+  for (int k = 0; k < 4; k++) {
+    r->s[k] = splitmix64(&seed);
+  }
+}
+
+/** Draws 64 random bits.
+
+Modified parameter:
+ - rng *r: the generator
+
+Returns:
+ - uint64_t: the bits
+**/
+uint64_t rng_next(rng *r) {
+  uint64_t *s = r->s;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+/** Draws a number below a bound, with a multiplication instead of a modulo.
+
+Modified parameter:
+ - rng *r: the generator
+
+Copied parameter:
+ - int bound: the number of possible values
+
+Returns:
+ - int: a number between 0 and bound - 1
+**/
+int rng_int(rng *r, int bound) {
+  return (int)(((rng_next(r) >> 32) * (uint64_t)bound) >> 32);
+}
+
+/** Gets the generator of the calling thread, seeded with 0 until rng_seed
+is called.
+
+Returns:
+ - rng*: the generator
+**/
+rng *rng_thread(void) {
+  if (!thread_rng_ready) {
+    rng_init(&thread_rng, 0);
+    thread_rng_ready = 1;
+  }
+  return &thread_rng;
+}
+
+/** Seeds the generator of the calling thread.
+
+Copied parameter:
+ - uint64_t seed: any value, 0 included
+
+No return
+**/
+void rng_seed(uint64_t seed) {
+  rng_init(&thread_rng, seed);
+  thread_rng_ready = 1;
+}
+
+/** Draws a seed from the operating system, so that two runs started at the
+same time, or one second apart, do not make the same puzzles.
+
+Returns:
+ - uint64_t: the seed
+**/
+uint64_t rng_random_seed(void) {
+  uint64_t seed;
+
+  if (getrandom(&seed, sizeof(seed), 0) == sizeof(seed)) {
+    return seed;
+  }
+
+  FILE *urandom = fopen("/dev/urandom", "rb");
+  if (urandom) {
+    size_t got = fread(&seed, sizeof(seed), 1, urandom);
+    fclose(urandom);
+    if (got == 1) {
+      return seed;
+    }
+  }
+
+  /* Last resort: the time, down to the nanosecond */
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  seed = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+  return splitmix64(&seed);
+}
+
+/** Derives the seed of item k of a run (such as puzzle k of --generate) from
+the seed of the run. The seed of the run is mixed before k is, so runs with
+close seeds share no items.
+
+Copied parameters:
+ - uint64_t seed: the seed of the run
+ - uint64_t k: the index of the item
+
+Returns:
+ - uint64_t: the seed of the item
+**/
+uint64_t rng_derive(uint64_t seed, uint64_t k) {
+  uint64_t x = splitmix64(&seed) ^ k;
+  return splitmix64(&x);
+}
@@ -0,0 +1,20 @@
+#ifndef RNG_FILE
+#define RNG_FILE
+
+#include <stdint.h>
+
+/* State of a xoshiro256** generator. The generation functions take the
+generator they draw from, so what they make only depends on its seed */
+typedef struct rng {
+  uint64_t s[4];
+} rng;
+
+void rng_init(rng *r, uint64_t seed);
+uint64_t rng_next(rng *r);
+int rng_int(rng *r, int bound);
+rng *rng_thread(void);
+void rng_seed(uint64_t seed);
+uint64_t rng_random_seed(void);
+uint64_t rng_derive(uint64_t seed, uint64_t k);
+
+#endif
@@ -5,17 +5,24 @@
  *
  * DESCRIPTION:
  *        Helper functions that check whether Takuzu grids are valid or completed.
+ *        The checks run on packed bitgrids; the int grid versions pack their
+ *        input first.
  *
  * PUBLIC FUNCTIONS:
  *        int no_redundant_row_column(int **grid, int grid_size[2]);
  *        int is_valid_row_column(int *row_columnn, int row_column_size);
  *        int is_valid_grid(int **grid, int grid_size[2], int verbose);
  *        int is_solved(int **grid, int grid_size[2]);
+ *        int check_line(line_t filled, line_t value, int line_size);
+ *        int bitgrid_no_redundant(const bitgrid *bg);
+ *        int bitgrid_is_valid(const bitgrid *bg, int verbose);
+ *        int bitgrid_is_solved(const bitgrid *bg);
  *
  **/
 
 #include "rules.h"
 #include "constants.h"
+#include "line_set.h"
 #include "utils.h"
 
 #include <stdio.h>
@@ -27,21 +34,9 @@ Copied parameters :
 Return : int
 */
 int no_redundant_row_column(int **grid, int grid_size[2]) {
-  for (int i = 0; i < grid_size[0]; i++) {
-    for (int j = 0; j < grid_size[1]; j++) {
-      if (i != j) {
-        if (is_same(grid[i], grid[j], grid_size[1])) {
-          return -2;
-        }
-
-        if (is_same(get_column(grid, i, grid_size[0]),
-                    get_column(grid, j, grid_size[1]), grid_size[0])) {
-          return -1;
-        }
-      }
-    }
-  }
-  return 1;
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return bitgrid_no_redundant(&bg);
 }
 
 /* Checks if the rows and columns of the grid are valid and respect the rules of
@@ -53,39 +48,67 @@ Copied parameters : *********
 Return : int* column
 */
 int is_valid_row_column(int *row_columnn, int row_column_size) {
-  int count[2] = {0, 0};
-  int count_continuous[2] = {0, 0};
-
-  for (int i = 0; i < row_column_size; i++) {
-    if (row_columnn[i] != -1) {
-      count[row_columnn[i]]++;
-      if (i > 0) {
-        if (row_columnn[i] == row_columnn[i - 1]) {
-          count_continuous[row_columnn[i]]++;
-        } else {
-          count_continuous[row_columnn[i - 1]] = 0;
-          count_continuous[row_columnn[i]] = 1;
-        }
-      } else {
-        count_continuous[row_columnn[i]] = 1;
-      }
-    } else if (i > 0) {
-      count_continuous[row_columnn[i - 1]] = 0;
-    }
+  line_t value;
+  line_t filled = pack_line(row_columnn, row_column_size, &value);
+  return check_line(filled, value, row_column_size);
+}
 
-    if (count_continuous[0] >= 3) {
-      return -4;
-    }
+/* Checks one packed line: 3 consecutive zeros or ones are found with shifts and
+ANDs, the number of zeros and ones with popcount
+Copied parameters :
+-line_t filled : bit i is set when cell i of the line is set
+-line_t value : bit i holds the value of cell i
+-int line_size : the number of cells in the line
+Return : int, 1 if valid, same error codes as is_valid_row_column otherwise
+*/
+int check_line(line_t filled, line_t value, int line_size) {
+  line_t ones = filled & value;
+  line_t zeros = filled & ~value;
 
-    if (count_continuous[1] >= 3) {
-      return -3;
-    }
+  if (zeros & (zeros >> 1) & (zeros >> 2)) {
+    return -4;
+  }
+
+  if (ones & (ones >> 1) & (ones >> 2)) {
+    return -3;
+  }
+
+  if (__builtin_popcountll(zeros) > line_size / 2) {
+    return -2;
+  }
+
+  if (__builtin_popcountll(ones) > line_size / 2) {
+    return -1;
+  }
+
+  return 1;
+}
 
-    if (count[0] > row_column_size / 2) {
+/* Check if two completed rows or two completed columns are the same. Each
+completed line is looked up in a hash set of the ones seen before it, so the
+check is linear in the number of lines. Rows have size[1] cells and there are
+size[0] of them, the other way around for columns
+Copied parameters :
+-const bitgrid *bg : the packed grid
+Return : int, -2 for a repeated row, -1 for a repeated column, 1 otherwise
+*/
+int bitgrid_no_redundant(const bitgrid *bg) {
+  line_t row_full = line_mask(bg->size[1]);
+  line_t col_full = line_mask(bg->size[0]);
+  line_set seen;
+
+  line_set_clear(&seen);
+  for (int i = 0; i < bg->size[0]; i++) {
+    if (bg->row_filled[i] == row_full &&
+        !line_set_insert(&seen, bg->row_value[i])) {
       return -2;
     }
+  }
 
-    if (count[1] > row_column_size / 2) {
+  line_set_clear(&seen);
+  for (int j = 0; j < bg->size[1]; j++) {
+    if (bg->col_filled[j] == col_full &&
+        !line_set_insert(&seen, bg->col_value[j])) {
       return -1;
     }
   }
@@ -93,61 +116,63 @@ int is_valid_row_column(int *row_columnn, int row_column_size) {
   return 1;
 }
 
-/* Checks if the whole grid is valid and display errors messages if not
-Copied parameters : 
--int *grid_size[2] :contains the size of the grid in the X and Y dimension
--int **grid : a 2D array which repesents a grid
--int verbose  ****
-Return : int* column
+/* Prints the error message matching a check_line error code
+Copied parameters :
+-const char *line_name : "Row" or "Column"
+-int idx : index of the line
+-int error : the error code returned by check_line
 */
-int is_valid_grid(int **grid, int grid_size[2], int verbose) {
-  for (int i = 0; i < grid_size[0]; i++) {
-    int *column = get_column(grid, i, grid_size[1]);
-    int col_return = is_valid_row_column(column, grid_size[1]);
-    int row_return = is_valid_row_column(grid[i], grid_size[0]);
-
-    if (col_return != 1) {
-      if (verbose) {
-        switch (col_return) {
-        case -4:
-          printf(RED "Column %d has 3 continuous zeros.\n" RESET, i);
-          break;
-        case -3:
-          printf(RED "Column %d has 3 continuous ones.\n" RESET, i);
-          break;
-        case -2:
-          printf(RED "Column %d has too many zeros.\n" RESET, i);
-          break;
-        case -1:
-          printf(RED "Column %d has too many ones.\n" RESET, i);
-          break;
+static void print_line_error(const char *line_name, int idx, int error) {
+  switch (error) {
+  case -4:
+    printf(RED "%s %d has 3 continuous zeros.\n" RESET, line_name, idx);
+    break;
+  case -3:
+    printf(RED "%s %d has 3 continuous ones.\n" RESET, line_name, idx);
+    break;
+  case -2:
+    printf(RED "%s %d has too many zeros.\n" RESET, line_name, idx);
+    break;
+  case -1:
+    printf(RED "%s %d has too many ones.\n" RESET, line_name, idx);
+    break;
+  }
+}
+
+/* Checks if the whole packed grid is valid and display errors messages if not
+Copied parameters :
+-const bitgrid *bg : the packed grid
+-int verbose : whether to print the first error found
+Return : int
+*/
+int bitgrid_is_valid(const bitgrid *bg, int verbose) {
+  int lines = bg->size[0] > bg->size[1] ? bg->size[0] : bg->size[1];
+
+  for (int i = 0; i < lines; i++) {
+    if (i < bg->size[1]) {
+      int col_return =
+          check_line(bg->col_filled[i], bg->col_value[i], bg->size[0]);
+      if (col_return != 1) {
+        if (verbose) {
+          print_line_error("Column", i, col_return);
         }
+        return 0;
       }
-      return 0;
     }
 
-    if (row_return != 1) {
-      if (verbose) {
-        switch (row_return) {
-        case -4:
-          printf(RED "Row %d has 3 continuous zeros.\n" RESET, i);
-          break;
-        case -3:
-          printf(RED "Row %d has 3 continuous ones.\n" RESET, i);
-          break;
-        case -2:
-          printf(RED "Row %d has too many zeros.\n" RESET, i);
-          break;
-        case -1:
-          printf(RED "Row %d has too many ones.\n" RESET, i);
-          break;
+    if (i < bg->size[0]) {
+      int row_return =
+          check_line(bg->row_filled[i], bg->row_value[i], bg->size[1]);
+      if (row_return != 1) {
+        if (verbose) {
+          print_line_error("Row", i, row_return);
         }
+        return 0;
       }
-      return 0;
     }
   }
 
-  int redundant_return = no_redundant_row_column(grid, grid_size);
+  int redundant_return = bitgrid_no_redundant(bg);
   if (redundant_return != 1) {
     if (verbose) {
       switch (redundant_return) {
@@ -166,20 +191,43 @@ int is_valid_grid(int **grid, int grid_size[2], int verbose) {
   return 1;
 }
 
-/* Verify if a grid is full, verify its validity
+/* Checks if the whole grid is valid and display errors messages if not
 Copied parameters : 
 -int *grid_size[2] :contains the size of the grid in the X and Y dimension
 -int **grid : a 2D array which repesents a grid
+-int verbose  ****
+Return : int* column
+*/
+int is_valid_grid(int **grid, int grid_size[2], int verbose) {
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return bitgrid_is_valid(&bg, verbose);
+}
+
+/* Verify if a packed grid is full, verify its validity
+Copied parameters :
+-const bitgrid *bg : the packed grid
 Return : int
 */
-int is_solved(int **grid, int grid_size[2]) {
-  for (int i = 0; i < grid_size[0]; i++) {
-    for (int j = 0; j < grid_size[1]; j++) {
-      if (grid[i][j] == -1) {
-        return 0;
-      }
+int bitgrid_is_solved(const bitgrid *bg) {
+  line_t row_full = line_mask(bg->size[1]);
+  for (int i = 0; i < bg->size[0]; i++) {
+    if (bg->row_filled[i] != row_full) {
+      return 0;
     }
   }
 
-  return is_valid_grid(grid, grid_size, 0);
+  return bitgrid_is_valid(bg, 0);
+}
+
+/* Verify if a grid is full, verify its validity
+Copied parameters : 
+-int *grid_size[2] :contains the size of the grid in the X and Y dimension
+-int **grid : a 2D array which repesents a grid
+Return : int
+*/
+int is_solved(int **grid, int grid_size[2]) {
+  bitgrid bg;
+  bitgrid_from_grid(&bg, grid, grid_size);
+  return bitgrid_is_solved(&bg);
 }
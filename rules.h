@@ -1,9 +1,16 @@
 #ifndef RULES_FILE
 #define RULES_FILE
 
+#include "bitboard.h"
+
 int no_redundant_row_column(int **grid, int grid_size[2]);
 int is_valid_row_column(int *row_columnn, int row_column_size);
 int is_valid_grid(int **grid, int grid_size[2], int verbose);
 int is_solved(int **grid, int grid_size[2]);
 
-#endif
\ No newline at end of file
+int check_line(line_t filled, line_t value, int line_size);
+int bitgrid_no_redundant(const bitgrid *bg);
+int bitgrid_is_valid(const bitgrid *bg, int verbose);
+int bitgrid_is_solved(const bitgrid *bg);
+
+#endif
@@ -0,0 +1,586 @@
+/**
+ * FILENAME: service.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Local puzzle service: answers requests on a Unix domain socket, one
+ *        line per request and one line per answer, except STATS whose report
+ *        spans several lines ending with END (see print_usage in cli.c and
+ *        the README). Puzzles come from rated pools, one per size served,
+ *        all started at start-up, so asking for a puzzle is usually a copy.
+ *        Other sizes are refused, so that clients cannot start producers.
+ *        The clients served at once are capped, and SOLVE and HINT give up
+ *        after a search budget, so that no client can hold the service. The
+ *        latency of the requests and the hits of the pools are reported by
+ *        STATS and when the service stops.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int run_service(const char *path, const int *sizes, int size_count,
+ *                        int capacity, int threads, uint64_t seed)
+ *
+ **/
+
+#include "service.h"
+#include "backtracking.h"
+#include "bitboard.h"
+#include "difficulty.h"
+#include "generator.h"
+#include "pool.h"
+#include "rules.h"
+#include "stats.h"
+#include "validate.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define REQUEST_LINE (MAX_GRID_SIZE * MAX_GRID_SIZE + 64)
+#define REPLY_LINE (2 * MAX_GRID_SIZE * MAX_GRID_SIZE + 128)
+
+/* Clients served at once; the next ones are answered with an error */
+#define MAX_CLIENTS 64
+
+/* Budget of the solving behind SOLVE and HINT, answered with "ERR timeout"
+when it runs out: a node of the depth-first search on a sparse 64x64 grid
+takes milliseconds, a conflict of the CDCL backend microseconds */
+#define SOLVE_MAX_NODES 128
+#define SOLVE_MAX_CONFLICTS 100000
+
+#define REQUEST_PUZZLE 0
+#define REQUEST_SOLVE 1
+#define REQUEST_VALIDATE 2
+#define REQUEST_HINT 3
+#define REQUEST_KINDS 4
+/* Requests that are not timed, and the end of a connection */
+#define REQUEST_OTHER -1
+#define REQUEST_QUIT -2
+
+/* Latency histogram: bucket b counts the requests answered within 2^b
+microseconds and not within 2^(b-1), the last one everything slower */
+#define LATENCY_BUCKETS 28
+
+static const char *request_names[REQUEST_KINDS] = {"puzzle", "solve",
+                                                   "validate", "hint"};
+
+typedef struct service {
+  int listener;
+  int capacity;
+  int threads;
+  rng seeds;
+  int clients;
+  puzzle_pool *pools[MAX_GRID_SIZE / 2 + 1];
+  long latency[REQUEST_KINDS][LATENCY_BUCKETS];
+  double total_time[REQUEST_KINDS];
+  pthread_mutex_t lock;
+} service;
+
+typedef struct service_client {
+  service *svc;
+  int fd;
+} service_client;
+
+/* Starts the pool of a size served, before any request
+Modified parameter :
+-service *svc : the service
+Copied parameter :
+-int size : an even size
+*/
+static void start_size_pool(service *svc, int size) {
+  int grid_size[2] = {size, size};
+
+  if (svc->pools[size / 2]) {
+    return;
+  }
+  svc->pools[size / 2] = malloc(sizeof(puzzle_pool));
+  pool_start(svc->pools[size / 2], grid_size, svc->capacity, svc->threads, 1,
+             rng_next(&svc->seeds));
+}
+
+/* Answers "PUZZLE <size> [tier]" with
+"OK <puzzle> <solution> <tier> <score> <id>", the ID being "-" for eased
+puzzles
+Modified parameters :
+-service *svc : the service
+-char *reply : receives the answer
+Copied parameter :
+-const char *args : the arguments of the request
+*/
+static void answer_puzzle(service *svc, const char *args, char *reply) {
+  int size, tier = POOL_ANY;
+  char word[16] = "any";
+
+  if (sscanf(args, "%d %15s", &size, word) < 1 || size < 2 ||
+      size > MAX_GRID_SIZE || size % 2) {
+    strcpy(reply, "ERR invalid size");
+    return;
+  }
+  if (strcasecmp(word, "any")) {
+    for (int t = 0; t < TIER_COUNT; t++) {
+      if (!strcasecmp(word, tier_name(t))) {
+        tier = t;
+      }
+    }
+    if (tier == POOL_ANY) {
+      strcpy(reply, "ERR invalid tier");
+      return;
+    }
+  }
+
+  /* The pools are all started before the first client connects */
+  puzzle_pool *pool = svc->pools[size / 2];
+  if (!pool) {
+    sprintf(reply, "ERR size %dx%d is not served", size, size);
+    return;
+  }
+
+  pool_entry entry;
+  if (pool_take(pool, tier, &entry) < 0) {
+    sprintf(reply, "ERR no %s puzzle of size %dx%d", word, size, size);
+    return;
+  }
+
+  int cells = size * size;
+  char id[PUZZLE_ID_LENGTH] = "-";
+  if (!entry.eased) {
+    format_puzzle_id(id, entry.solution.size, entry.seed);
+  }
+  strcpy(reply, "OK ");
+  bitgrid_to_string(&entry.puzzle, reply + 3);
+  reply[3 + cells] = ' ';
+  bitgrid_to_string(&entry.solution, reply + 4 + cells);
+  sprintf(reply + 4 + 2 * cells, " %s %d %s", tier_name(entry.tier),
+          entry.score, id);
+}
+
+/* Answers "SOLVE <grid>" with "OK <solution>", or "ERR timeout" when the
+search runs out of budget
+Copied parameter :
+-const char *args : the arguments of the request
+Modified parameter :
+-char *reply : receives the answer
+*/
+static void answer_solve(const char *args, char *reply) {
+  bitgrid bg;
+  int solved;
+
+  if (!bitgrid_from_string(&bg, args)) {
+    strcpy(reply, "ERR invalid");
+  } else if ((solved = bitgrid_solve_limited(&bg, SOLVE_MAX_NODES,
+                                             SOLVE_MAX_CONFLICTS)) < 0) {
+    strcpy(reply, "ERR timeout");
+  } else if (!solved || !bitgrid_is_solved(&bg)) {
+    strcpy(reply, "ERR unsolvable");
+  } else {
+    strcpy(reply, "OK ");
+    bitgrid_to_string(&bg, reply + 3);
+  }
+}
+
+/* Answers "VALIDATE <grid>" with "OK valid", "OK incomplete" when the
+filled cells break no rule, or "OK invalid", followed for a completed grid by
+the line and the rule it breaks
+Copied parameter :
+-const char *args : the arguments of the request
+Modified parameter :
+-char *reply : receives the answer
+*/
+static void answer_validate(const char *args, char *reply) {
+  bitgrid bg;
+  grid_violation violation;
+
+  if (!bitgrid_from_string(&bg, args)) {
+    strcpy(reply, "ERR invalid");
+    return;
+  }
+
+  int complete = 1;
+  for (int i = 0; i < bg.size[0]; i++) {
+    complete &= bg.row_filled[i] == line_mask(bg.size[1]);
+  }
+  if (!complete) {
+    strcpy(reply, bitgrid_is_valid(&bg, 0) ? "OK incomplete" : "OK invalid");
+  } else if (validate_grid(bg.row_value, bg.size, &violation)) {
+    strcpy(reply, "OK valid");
+  } else {
+    sprintf(reply, "OK invalid %d %s", violation.line,
+            violation_name(violation.kind));
+  }
+}
+
+/* Answers "HINT <grid>" with "OK <row> <col> <value> <technique>": the cell
+a person would fill next, and how, or "ERR timeout" when solving the grid
+runs out of budget
+Copied parameter :
+-const char *args : the arguments of the request
+Modified parameter :
+-char *reply : receives the answer
+*/
+static void answer_hint(const char *args, char *reply) {
+  bitgrid bg, solution;
+  solve_trace trace;
+
+  if (!bitgrid_from_string(&bg, args)) {
+    strcpy(reply, "ERR invalid");
+    return;
+  }
+  solution = bg;
+  int solved =
+      bitgrid_solve_limited(&solution, SOLVE_MAX_NODES, SOLVE_MAX_CONFLICTS);
+  if (solved < 0) {
+    strcpy(reply, "ERR timeout");
+  } else if (!solved || !bitgrid_is_solved(&solution) ||
+      !trace_puzzle(&bg, &solution, &trace)) {
+    strcpy(reply, "ERR unsolvable");
+  } else if (trace.length == 0) {
+    strcpy(reply, "ERR complete");
+  } else {
+    const trace_step *step = &trace.steps[0];
+    sprintf(reply, "OK %d %d %d %s", step->row, step->col, step->value,
+            technique_name(step->technique));
+  }
+}
+
+/* Counts an answered request in the latency histogram of its kind
+Modified parameter :
+-service *svc : the service
+Copied parameters :
+-int kind : the REQUEST_* kind
+-double seconds : the time taken to answer
+*/
+static void record_latency(service *svc, int kind, double seconds) {
+  double micros = seconds * 1e6;
+  int b = 0;
+
+  while (b < LATENCY_BUCKETS - 1 && (double)(1L << b) < micros) {
+    b++;
+  }
+  pthread_mutex_lock(&svc->lock);
+  svc->latency[kind][b]++;
+  svc->total_time[kind] += seconds;
+  pthread_mutex_unlock(&svc->lock);
+}
+
+/* Finds the bucket of the latency histogram below which a share of the
+requests was answered
+Copied parameters :
+-const long *histogram : the LATENCY_BUCKETS counts
+-long count : their sum
+-double share : the share, 0.5 for the median
+Return : long, the bound of that bucket in microseconds
+*/
+static long latency_bound(const long *histogram, long count, double share) {
+  long seen = 0;
+
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    seen += histogram[b];
+    if (seen >= share * count) {
+      return 1L << b;
+    }
+  }
+  return 1L << (LATENCY_BUCKETS - 1);
+}
+
+/* Writes the latency of each kind of request, with its histogram, and the
+counters of every ring of the pools
+Modified parameters :
+-service *svc : the service
+-FILE *out : the output
+*/
+static void print_report(service *svc, FILE *out) {
+  pthread_mutex_lock(&svc->lock);
+  for (int kind = 0; kind < REQUEST_KINDS; kind++) {
+    long count = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      count += svc->latency[kind][b];
+    }
+    if (!count) {
+      continue;
+    }
+
+    const long *histogram = svc->latency[kind];
+    fprintf(out,
+            "%s: %ld requests, mean %.1f us, p50 <= %ld us, p90 <= %ld us, "
+            "p99 <= %ld us\n",
+            request_names[kind], count, svc->total_time[kind] * 1e6 / count,
+            latency_bound(histogram, count, 0.5),
+            latency_bound(histogram, count, 0.9),
+            latency_bound(histogram, count, 0.99));
+    fprintf(out, "%s histogram:", request_names[kind]);
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      if (histogram[b]) {
+        fprintf(out, " <=%ldus:%ld", 1L << b, histogram[b]);
+      }
+    }
+    fprintf(out, "\n");
+  }
+
+  pthread_mutex_unlock(&svc->lock);
+
+  for (int s = 0; s <= MAX_GRID_SIZE / 2; s++) {
+    for (int t = 0; svc->pools[s] && t < TIER_COUNT; t++) {
+      pool_counters counters;
+      pool_read_counters(svc->pools[s], t, &counters);
+      long asked = counters.hits + counters.misses;
+      fprintf(out, "pool %dx%d %s: %d/%d ready, %ld hits, %ld misses",
+              2 * s, 2 * s, tier_name(t), counters.ready, counters.capacity,
+              counters.hits, counters.misses);
+      if (asked) {
+        fprintf(out, " (%.1f%% hits)", 100.0 * counters.hits / asked);
+      }
+      fprintf(out, "%s\n",
+              counters.given_up ? ", not produced at this size" : "");
+    }
+  }
+}
+
+/* Answers one request line
+Modified parameters :
+-service *svc : the service
+-char *line : the request, cut into words
+-char *reply : receives the answer, empty when it was written to out
+-FILE *out : the connection, for the answers of several lines
+Return : int, the REQUEST_* kind of the request
+*/
+static int answer_request(service *svc, char *line, char *reply, FILE *out) {
+  char *save;
+  char *command = strtok_r(line, " \t\r\n", &save);
+  char *args = strtok_r(NULL, "\r\n", &save);
+
+  reply[0] = '\0';
+  if (!args) {
+    args = "";
+  }
+  if (!command) {
+    strcpy(reply, "ERR empty request");
+  } else if (!strcasecmp(command, "PUZZLE")) {
+    answer_puzzle(svc, args, reply);
+    return REQUEST_PUZZLE;
+  } else if (!strcasecmp(command, "SOLVE")) {
+    answer_solve(args, reply);
+    return REQUEST_SOLVE;
+  } else if (!strcasecmp(command, "VALIDATE")) {
+    answer_validate(args, reply);
+    return REQUEST_VALIDATE;
+  } else if (!strcasecmp(command, "HINT")) {
+    answer_hint(args, reply);
+    return REQUEST_HINT;
+  } else if (!strcasecmp(command, "STATS")) {
+    print_report(svc, out);
+    fprintf(out, "END\n");
+  } else if (!strcasecmp(command, "QUIT")) {
+    return REQUEST_QUIT;
+  } else {
+    strcpy(reply, "ERR unknown request");
+  }
+  return REQUEST_OTHER;
+}
+
+/* Connection thread: answers the requests of one client until it leaves,
+then frees its place among the MAX_CLIENTS
+Modified parameter :
+-void *arg : the service_client, freed here
+Return : NULL
+*/
+static void *serve_client(void *arg) {
+  service_client *client = arg;
+  service *svc = client->svc;
+  FILE *in = fdopen(client->fd, "r");
+  FILE *out = fdopen(dup(client->fd), "w");
+  char *line = malloc(REQUEST_LINE);
+  char *reply = malloc(REPLY_LINE);
+
+  while (in && out && fgets(line, REQUEST_LINE, in)) {
+    size_t len = strlen(line);
+    if (len == REQUEST_LINE - 1 && line[len - 1] != '\n') {
+      int c;
+      do {
+        c = fgetc(in);
+      } while (c != '\n' && c != EOF);
+      fputs("ERR request too long\n", out);
+      fflush(out);
+      continue;
+    }
+
+    double start = stats_clock();
+    int kind = answer_request(svc, line, reply, out);
+    if (kind == REQUEST_QUIT) {
+      break;
+    }
+    if (kind >= 0) {
+      record_latency(svc, kind, stats_clock() - start);
+    }
+    if (reply[0]) {
+      fprintf(out, "%s\n", reply);
+    }
+    if (fflush(out)) {
+      break;
+    }
+  }
+
+  if (in) {
+    fclose(in);
+  }
+  if (out) {
+    fclose(out);
+  }
+  free(line);
+  free(reply);
+  free(client);
+  pthread_mutex_lock(&svc->lock);
+  svc->clients--;
+  pthread_mutex_unlock(&svc->lock);
+  stats_flush();
+  return NULL;
+}
+
+/* Accepting thread: gives each client its own thread, until the listening
+socket is shut down. Beyond MAX_CLIENTS clients at once, a new client gets
+"ERR too many clients" and is disconnected
+Modified parameter :
+-void *arg : the service
+Return : NULL
+*/
+static void *accept_clients(void *arg) {
+  service *svc = arg;
+
+  for (;;) {
+    int fd = accept(svc->listener, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
+
+    pthread_mutex_lock(&svc->lock);
+    int full = svc->clients >= MAX_CLIENTS;
+    svc->clients += !full;
+    pthread_mutex_unlock(&svc->lock);
+    if (full) {
+      static const char busy[] = "ERR too many clients\n";
+      send(fd, busy, sizeof(busy) - 1, MSG_DONTWAIT);
+      close(fd);
+      continue;
+    }
+
+    service_client *client = malloc(sizeof(service_client));
+    pthread_t thread;
+    client->svc = svc;
+    client->fd = fd;
+    if (pthread_create(&thread, NULL, serve_client, client)) {
+      close(fd);
+      free(client);
+      pthread_mutex_lock(&svc->lock);
+      svc->clients--;
+      pthread_mutex_unlock(&svc->lock);
+    } else {
+      pthread_detach(thread);
+    }
+  }
+  return NULL;
+}
+
+/* Creates the listening socket. A socket file left by a service that is gone
+is replaced, one that still answers is not
+Copied parameter :
+-const char *path : the path of the socket
+Return : int, the socket, -1 on error
+*/
+static int open_listener(const char *path) {
+  struct sockaddr_un addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  int bound = !bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+  if (!bound && errno == EADDRINUSE) {
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    int alive = !connect(probe, (struct sockaddr *)&addr, sizeof(addr));
+    close(probe);
+    if (alive) {
+      fprintf(stderr, "%s is already served.\n", path);
+      close(fd);
+      return -1;
+    }
+    unlink(path);
+    bound = !bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+  }
+  if (!bound || listen(fd, 64)) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/** Serves puzzles on a Unix domain socket until SIGINT or SIGTERM, then
+prints the report of STATS on standard error. Only the given sizes are
+served: their pools start filling at once, and requests for other sizes are
+refused. The producers are not stopped: they end with the process.
+
+Copied parameters:
+ - const char *path: the path of the socket
+ - const int *sizes: the sizes served
+ - int size_count: the number of such sizes
+ - int capacity: the number of puzzles kept ready per size and tier
+ - int threads: the number of producer threads per size
+ - uint64_t seed: seed of the puzzles
+
+Returns:
+ - int: the exit status of the program
+**/
+int run_service(const char *path, const int *sizes, int size_count,
+                int capacity, int threads, uint64_t seed) {
+  static service svc;
+  sigset_t signals;
+  int signal_number;
+  pthread_t acceptor;
+
+  /* Blocked in every thread: the signals are taken by sigwait below */
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  svc.listener = open_listener(path);
+  if (svc.listener < 0) {
+    return 1;
+  }
+  svc.capacity = capacity;
+  svc.threads = threads;
+  rng_init(&svc.seeds, seed);
+  pthread_mutex_init(&svc.lock, NULL);
+  for (int k = 0; k < size_count; k++) {
+    start_size_pool(&svc, sizes[k]);
+  }
+
+  pthread_create(&acceptor, NULL, accept_clients, &svc);
+  fprintf(stderr, "Serving puzzles on %s\n", path);
+  sigwait(&signals, &signal_number);
+
+  shutdown(svc.listener, SHUT_RDWR);
+  pthread_join(acceptor, NULL);
+  close(svc.listener);
+  unlink(path);
+  print_report(&svc, stderr);
+  return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef SERVICE_FILE
+#define SERVICE_FILE
+
+#include <stdint.h>
+
+int run_service(const char *path, const int *sizes, int size_count,
+                int capacity, int threads, uint64_t seed);
+
+#endif
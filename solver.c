@@ -0,0 +1,307 @@
+/**
+ * FILENAME: solver.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Incremental search state for the backtracking solver: per-line counts
+ *        of zeros and ones and the hash sets of completed lines, updated and
+ *        rolled back in O(1) on every assignment, and the trail of assigned
+ *        cells.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int solver_load(solver_state *s, const bitgrid *bg)
+ *        int solver_assign(solver_state *s, int i, int j, int value)
+ *        void solver_undo(solver_state *s, int trail_mark)
+ *        int solver_next_cell(const solver_state *s, int next[2])
+ *        int solver_constrained_cell(const solver_state *s, int next[2])
+ *        int solver_quota_value(const solver_state *s, int i, int j)
+ *        void solver_mark_all(solver_state *s)
+ *
+ **/
+
+#include "solver.h"
+#include "rules.h"
+#include "stats.h"
+
+#include <string.h>
+
+/* Checks a line that was valid before one of its cells was set: only the
+counts and the triples can have changed
+Copied parameters :
+-line_t filled, line_t value : the packed line
+-const int count[2] : number of zeros and ones in the line
+-int line_size : the number of cells in the line
+Return : int
+*/
+static int line_still_valid(line_t filled, line_t value, const int count[2],
+                            int line_size) {
+  if (count[0] > line_size / 2 || count[1] > line_size / 2) {
+    return 0;
+  }
+
+  line_t ones = filled & value;
+  line_t zeros = filled & ~value;
+  return !((ones & (ones >> 1) & (ones >> 2)) |
+           (zeros & (zeros >> 1) & (zeros >> 2)));
+}
+
+/* Records a line that was just completed in the set of its direction
+Modified parameters :
+-line_set *set : the completed rows or columns
+-line_t *in_set : bitmask of the lines that own an entry of set
+Copied parameters :
+-line_t value : the value word of the line
+-int idx : index of the line
+Return : int, 0 if an identical line was already completed
+*/
+static int add_completed_line(line_set *set, line_t *in_set, line_t value,
+                              int idx) {
+  if (!line_set_insert(set, value)) {
+    return 0;
+  }
+  *in_set |= (line_t)1 << idx;
+  return 1;
+}
+
+/* Builds the search state of a packed grid
+Modified parameter :
+-solver_state *s : the state to build
+Copied parameter :
+-const bitgrid *bg : the starting grid
+Return : int, whether the starting grid is valid
+*/
+int solver_load(solver_state *s, const bitgrid *bg) {
+  memset(s, 0, sizeof(solver_state));
+  s->grid = *bg;
+  s->row_kernel = get_completion_kernel(bg->size[1]);
+  s->col_kernel = get_completion_kernel(bg->size[0]);
+
+  line_t row_full = line_mask(bg->size[1]);
+  line_t col_full = line_mask(bg->size[0]);
+
+  for (int i = 0; i < bg->size[0]; i++) {
+    s->row_count[i][1] = __builtin_popcountll(bg->row_value[i]);
+    s->row_count[i][0] =
+        __builtin_popcountll(bg->row_filled[i]) - s->row_count[i][1];
+    if (bg->row_filled[i] == row_full) {
+      s->full_rows |= (line_t)1 << i;
+      add_completed_line(&s->row_set, &s->rows_in_set, bg->row_value[i], i);
+    }
+  }
+
+  for (int j = 0; j < bg->size[1]; j++) {
+    s->col_count[j][1] = __builtin_popcountll(bg->col_value[j]);
+    s->col_count[j][0] =
+        __builtin_popcountll(bg->col_filled[j]) - s->col_count[j][1];
+    if (bg->col_filled[j] == col_full) {
+      s->full_cols |= (line_t)1 << j;
+      add_completed_line(&s->col_set, &s->cols_in_set, bg->col_value[j], j);
+    }
+  }
+
+  solver_mark_all(s);
+
+  STATS_START_CHECK(timer);
+  int valid = bitgrid_is_valid(bg, 0);
+  STATS_STOP_CHECK(timer);
+  return valid;
+}
+
+/* Sets an empty cell and checks the row and the column it belongs to. The
+assignment is pushed on the trail even when it is invalid, so the caller must
+undo it with solver_undo
+Modified parameter :
+-solver_state *s : the search state
+Copied parameters :
+-int i, int j : the cell to set
+-int value : 0 or 1
+Return : int, whether the grid is still valid
+*/
+int solver_assign(solver_state *s, int i, int j, int value) {
+  bitgrid *bg = &s->grid;
+
+  bitgrid_set(bg, i, j, value);
+  s->trail[s->trail_len++] = (uint16_t)(i * MAX_GRID_SIZE + j);
+  s->dirty_rows |= (line_t)1 << i;
+  s->dirty_cols |= (line_t)1 << j;
+  s->pending_rows |= (line_t)1 << i;
+  s->pending_cols |= (line_t)1 << j;
+  s->row_count[i][value]++;
+  s->col_count[j][value]++;
+
+  STATS_START_CHECK(timer);
+  int valid = line_still_valid(bg->row_filled[i], bg->row_value[i],
+                               s->row_count[i], bg->size[1]) &&
+              line_still_valid(bg->col_filled[j], bg->col_value[j],
+                               s->col_count[j], bg->size[0]);
+
+  if (s->row_count[i][0] + s->row_count[i][1] == bg->size[1]) {
+    s->full_rows |= (line_t)1 << i;
+    valid = add_completed_line(&s->row_set, &s->rows_in_set,
+                               bg->row_value[i], i) &&
+            valid;
+  }
+
+  if (s->col_count[j][0] + s->col_count[j][1] == bg->size[0]) {
+    s->full_cols |= (line_t)1 << j;
+    valid = add_completed_line(&s->col_set, &s->cols_in_set,
+                               bg->col_value[j], j) &&
+            valid;
+  }
+
+  STATS_STOP_CHECK(timer);
+  return valid;
+}
+
+/* Empties the cells assigned since the trail had length trail_mark. Dirty
+and pending lines are dropped: they were only marked because of these cells
+Modified parameter :
+-solver_state *s : the search state
+Copied parameter :
+-int trail_mark : trail length to go back to
+*/
+void solver_undo(solver_state *s, int trail_mark) {
+  while (s->trail_len > trail_mark) {
+    int cell = s->trail[--s->trail_len];
+    int i = cell / MAX_GRID_SIZE;
+    int j = cell % MAX_GRID_SIZE;
+    int value = bitgrid_get(&s->grid, i, j);
+
+    if ((s->rows_in_set >> i) & 1) {
+      line_set_remove(&s->row_set, s->grid.row_value[i]);
+      s->rows_in_set &= ~((line_t)1 << i);
+    }
+    if ((s->cols_in_set >> j) & 1) {
+      line_set_remove(&s->col_set, s->grid.col_value[j]);
+      s->cols_in_set &= ~((line_t)1 << j);
+    }
+
+    bitgrid_unset(&s->grid, i, j);
+    s->row_count[i][value]--;
+    s->col_count[j][value]--;
+    s->full_rows &= ~((line_t)1 << i);
+    s->full_cols &= ~((line_t)1 << j);
+  }
+
+  s->dirty_rows = 0;
+  s->dirty_cols = 0;
+  s->pending_rows = 0;
+  s->pending_cols = 0;
+}
+
+/* Finds the first empty cell in row-major order, using the completed rows
+mask to skip full rows
+Copied parameter :
+-const solver_state *s : the search state
+Modified parameter :
+-int next[2] : receives the row and column of the cell, -1 if the grid is full
+Return : int, 1 if an empty cell was found
+*/
+int solver_next_cell(const solver_state *s, int next[2]) {
+  line_t open_rows = ~s->full_rows & line_mask(s->grid.size[0]);
+
+  if (!open_rows) {
+    next[0] = -1;
+    next[1] = -1;
+    return 0;
+  }
+
+  next[0] = __builtin_ctzll(open_rows);
+  next[1] = __builtin_ctzll(~s->grid.row_filled[next[0]] &
+                            line_mask(s->grid.size[1]));
+  return 1;
+}
+
+/* Index of the fullest line among a set of lines, from their counts
+Copied parameters :
+-line_t lines : the lines to choose from, not empty
+-const int count[][2] : number of zeros and ones of every line
+Modified parameter :
+-int *filled : receives the number of filled cells of the line
+Return : int, the index of the line (the first one on ties)
+*/
+static int fullest_line(line_t lines, const int count[][2], int *filled) {
+  int best = -1;
+
+  *filled = -1;
+  for (; lines; lines &= lines - 1) {
+    int k = __builtin_ctzll(lines);
+    if (count[k][0] + count[k][1] > *filled) {
+      *filled = count[k][0] + count[k][1];
+      best = k;
+    }
+  }
+  return best;
+}
+
+/* Finds the most constrained empty cell. Once the rules have run every empty
+cell can still take both values, so the cell is the one whose row and column
+are the most filled: the fullest open line, row or column, then the fullest
+crossing line among its empty cells. Only the counts kept by solver_assign
+are read, so the choice costs one pass over the rows and the columns instead
+of one over the cells
+Copied parameter :
+-const solver_state *s : the search state
+Modified parameter :
+-int next[2] : receives the row and column of the cell, -1 if the grid is full
+Return : int, 1 if an empty cell was found
+*/
+int solver_constrained_cell(const solver_state *s, int next[2]) {
+  line_t open_rows = ~s->full_rows & line_mask(s->grid.size[0]);
+  line_t open_cols = ~s->full_cols & line_mask(s->grid.size[1]);
+  int row_filled, col_filled, crossing;
+
+  if (!open_rows) {
+    next[0] = -1;
+    next[1] = -1;
+    return 0;
+  }
+
+  int i = fullest_line(open_rows, s->row_count, &row_filled);
+  int j = fullest_line(open_cols, s->col_count, &col_filled);
+
+  if (row_filled >= col_filled) {
+    line_t empty = ~s->grid.row_filled[i] & line_mask(s->grid.size[1]);
+    j = fullest_line(empty, s->col_count, &crossing);
+  } else {
+    line_t empty = ~s->grid.col_filled[j] & line_mask(s->grid.size[0]);
+    i = fullest_line(empty, s->row_count, &crossing);
+  }
+
+  next[0] = i;
+  next[1] = j;
+  return 1;
+}
+
+/* Chooses the value to try first in an empty cell from the quotas of its row
+and column: the value that both lines still need the most
+Copied parameters :
+-const solver_state *s : the search state
+-int i, int j : the cell
+Return : int, the value, -1 if both values are needed as much
+*/
+int solver_quota_value(const solver_state *s, int i, int j) {
+  int need[2];
+
+  for (int v = 0; v < 2; v++) {
+    need[v] = s->grid.size[1] / 2 - s->row_count[i][v] + s->grid.size[0] / 2 -
+              s->col_count[j][v];
+  }
+  if (need[0] == need[1]) {
+    return -1;
+  }
+  return need[1] > need[0];
+}
+
+/* Marks every line dirty and pending, so that the next propagation looks at
+the whole grid again
+Modified parameter :
+-solver_state *s : the search state
+*/
+void solver_mark_all(solver_state *s) {
+  s->dirty_rows = line_mask(s->grid.size[0]);
+  s->dirty_cols = line_mask(s->grid.size[1]);
+  s->pending_rows = s->dirty_rows;
+  s->pending_cols = s->dirty_cols;
+}
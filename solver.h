@@ -0,0 +1,44 @@
+#ifndef SOLVER_FILE
+#define SOLVER_FILE
+
+#include "bitboard.h"
+#include "kernels.h"
+#include "line_set.h"
+
+/* Search state kept up to date on every assignment so that each node only
+re-checks the row and the column it touched. Assigned cells are pushed on the
+trail (as i * MAX_GRID_SIZE + j) so that a whole subtree can be undone, and
+the lines they touched are marked dirty for the cheap propagation rules and
+pending for the full line analysis. Completed lines are kept in a line_set per
+direction (rows_in_set tells which rows own an entry) so that a repeated line
+is found with one lookup. The line analysis kernels of the row and column
+sizes are picked once, when the state is loaded. */
+typedef struct solver_state {
+  bitgrid grid;
+  int row_count[MAX_GRID_SIZE][2];
+  int col_count[MAX_GRID_SIZE][2];
+  line_t full_rows;
+  line_t full_cols;
+  line_t dirty_rows;
+  line_t dirty_cols;
+  line_t pending_rows;
+  line_t pending_cols;
+  line_set row_set;
+  line_set col_set;
+  line_t rows_in_set;
+  line_t cols_in_set;
+  completion_kernel row_kernel;
+  completion_kernel col_kernel;
+  int trail_len;
+  uint16_t trail[MAX_GRID_SIZE * MAX_GRID_SIZE];
+} solver_state;
+
+int solver_load(solver_state *s, const bitgrid *bg);
+int solver_assign(solver_state *s, int i, int j, int value);
+void solver_undo(solver_state *s, int trail_mark);
+int solver_next_cell(const solver_state *s, int next[2]);
+int solver_constrained_cell(const solver_state *s, int next[2]);
+int solver_quota_value(const solver_state *s, int i, int j);
+void solver_mark_all(solver_state *s);
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * FILENAME: stats.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Solver statistics: nodes, backtracks, depth, validity checks,
+ *        propagations and time, counted per thread by the STATS_* macros when
+ *        the program is built with SOLVER_STATS, and summed over the threads
+ *        that flush their counters.
+ *
+ * PUBLIC FUNCTIONS:
+ *        int stats_enabled(void)
+ *        void stats_reset(void)
+ *        void stats_get(solver_stats *stats)
+ *        void stats_flush(void)
+ *        void stats_total(solver_stats *stats)
+ *        void stats_print(const solver_stats *stats, FILE *out)
+ *
+ **/
+
+#include "stats.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+_Thread_local solver_stats thread_stats;
+_Thread_local long stats_depth = 0;
+
+static solver_stats total_stats;
+static pthread_mutex_t total_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Tells whether the program counts solver statistics.
+
+Returns:
+ - int: 1 if it was built with SOLVER_STATS
+**/
+int stats_enabled(void) {
+#ifdef SOLVER_STATS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/** Reads the monotonic clock.
+
+Returns:
+ - double: the time in seconds
+**/
+double stats_clock(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/** Clears the counters of the calling thread and the total.
+
+No return
+**/
+void stats_reset(void) {
+  pthread_mutex_lock(&total_lock);
+  memset(&total_stats, 0, sizeof(solver_stats));
+  pthread_mutex_unlock(&total_lock);
+  memset(&thread_stats, 0, sizeof(solver_stats));
+  stats_depth = 0;
+}
+
+/** Gets the counters of the calling thread.
+
+Modified parameter:
+ - solver_stats *stats: receives the counters
+
+No return
+**/
+void stats_get(solver_stats *stats) { *stats = thread_stats; }
+
+/** Adds the counters of the calling thread to the total and clears them.
+Worker threads call it before they exit.
+
+No return
+**/
+void stats_flush(void) {
+  pthread_mutex_lock(&total_lock);
+  total_stats.nodes += thread_stats.nodes;
+  total_stats.backtracks += thread_stats.backtracks;
+  total_stats.validity_checks += thread_stats.validity_checks;
+  total_stats.propagations += thread_stats.propagations;
+  total_stats.search_time += thread_stats.search_time;
+  total_stats.validation_time += thread_stats.validation_time;
+  if (thread_stats.max_depth > total_stats.max_depth) {
+    total_stats.max_depth = thread_stats.max_depth;
+  }
+  pthread_mutex_unlock(&total_lock);
+  memset(&thread_stats, 0, sizeof(solver_stats));
+}
+
+/** Gets the counters of every thread, the calling one included.
+
+Modified parameter:
+ - solver_stats *stats: receives the sums (the maximum for max_depth)
+
+No return
+**/
+void stats_total(solver_stats *stats) {
+  stats_flush();
+  pthread_mutex_lock(&total_lock);
+  *stats = total_stats;
+  pthread_mutex_unlock(&total_lock);
+}
+
+/** Prints counters in a human-readable form.
+
+Copied parameter:
+ - const solver_stats *stats: the counters
+
+Modified parameter:
+ - FILE *out: where they are printed
+
+No return
+**/
+void stats_print(const solver_stats *stats, FILE *out) {
+  if (!stats_enabled()) {
+    fprintf(out, "Solver statistics are not compiled in: rebuild with "
+                 "\"make clean && make STATS=1\".\n");
+    return;
+  }
+
+  fprintf(out,
+          "nodes            %ld\n"
+          "backtracks       %ld\n"
+          "max depth        %ld\n"
+          "validity checks  %ld\n"
+          "propagations     %ld\n"
+          "search time      %.6f s\n"
+          "validation time  %.6f s\n",
+          stats->nodes, stats->backtracks, stats->max_depth,
+          stats->validity_checks, stats->propagations, stats->search_time,
+          stats->validation_time);
+}
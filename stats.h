@@ -0,0 +1,69 @@
+#ifndef STATS_FILE
+#define STATS_FILE
+
+#include <stdio.h>
+
+/* Counters of the solvers. Times are in seconds: search_time is the time
+spent in the solvers apart from the validity checks, which are counted in
+validation_time. */
+typedef struct solver_stats {
+  long nodes;
+  long backtracks;
+  long max_depth;
+  long validity_checks;
+  long propagations;
+  double search_time;
+  double validation_time;
+} solver_stats;
+
+int stats_enabled(void);
+void stats_reset(void);
+void stats_get(solver_stats *stats);
+void stats_flush(void);
+void stats_total(solver_stats *stats);
+void stats_print(const solver_stats *stats, FILE *out);
+double stats_clock(void);
+
+/* The counting macros below are used in the solvers' hot paths. They only
+exist when the program is built with SOLVER_STATS defined (make STATS=1) and
+expand to nothing otherwise. Each thread counts in its own solver_stats. */
+#ifdef SOLVER_STATS
+
+extern _Thread_local solver_stats thread_stats;
+extern _Thread_local long stats_depth;
+
+#define STATS_INC(field) (thread_stats.field++)
+#define STATS_DESCEND()                                                        \
+  (++stats_depth > thread_stats.max_depth ? thread_stats.max_depth =           \
+                                                stats_depth                    \
+                                          : 0)
+#define STATS_ASCEND() (stats_depth--)
+#define STATS_MAX(field, value)                                                \
+  ((value) > thread_stats.field ? thread_stats.field = (value) : 0)
+/* Starts timing a solver call; the validity checks done during the call are
+taken out of its search time by STATS_STOP_SEARCH */
+#define STATS_START_SEARCH(timer)                                              \
+  double timer = stats_clock();                                                \
+  double timer##_checks = thread_stats.validation_time
+#define STATS_STOP_SEARCH(timer)                                               \
+  (thread_stats.search_time += stats_clock() - timer -                        \
+                               (thread_stats.validation_time - timer##_checks))
+#define STATS_START_CHECK(timer) double timer = stats_clock()
+#define STATS_STOP_CHECK(timer)                                                \
+  (thread_stats.validity_checks++,                                             \
+   thread_stats.validation_time += stats_clock() - timer)
+
+#else
+
+#define STATS_INC(field) ((void)0)
+#define STATS_DESCEND() ((void)0)
+#define STATS_ASCEND() ((void)0)
+#define STATS_MAX(field, value) ((void)0)
+#define STATS_START_SEARCH(timer)
+#define STATS_STOP_SEARCH(timer) ((void)0)
+#define STATS_START_CHECK(timer)
+#define STATS_STOP_CHECK(timer) ((void)0)
+
+#endif
+
+#endif
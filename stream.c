@@ -0,0 +1,231 @@
+/**
+ * FILENAME: stream.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Streaming solver: reads one puzzle per line ('0', '1' or '.' per
+ *        cell, row after row, on a square grid) and writes one line per
+ *        puzzle in the same order: the solution, "unsolvable" or "invalid".
+ *        A reader thread, solver workers and the writer share a fixed ring of
+ *        slots, so memory does not grow with the input and the writer keeps
+ *        the input order whatever worker finishes first.
+ *
+ * PUBLIC FUNCTIONS:
+ *        long solve_stream(FILE *in, FILE *out, int threads, long *total)
+ *
+ **/
+
+#include "stream.h"
+#include "backtracking.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Puzzles in flight: read, being solved or waiting to be written */
+#define STREAM_SLOTS 256
+#define STREAM_LINE (2 * MAX_GRID_SIZE * MAX_GRID_SIZE + 64)
+
+#define SLOT_FREE 0
+#define SLOT_READ 1
+#define SLOT_SOLVING 2
+#define SLOT_DONE 3
+
+typedef struct stream_slot {
+  int state;
+  char text[STREAM_LINE];
+} stream_slot;
+
+/* Puzzle seq lives in slot seq % STREAM_SLOTS. The reader fills slots up to
+STREAM_SLOTS puzzles ahead of the writer, the workers solve them in input
+order and the writer empties them in input order */
+typedef struct stream_pipe {
+  FILE *in;
+  stream_slot *slots;
+  long read;
+  long claimed;
+  long written;
+  int eof;
+  pthread_mutex_t lock;
+  pthread_cond_t slot_freed;
+  pthread_cond_t puzzle_read;
+  pthread_cond_t puzzle_done;
+} stream_pipe;
+
+/* Reads the rest of a line that did not fit in the buffer
+Modified parameter :
+-FILE *in : the input
+*/
+static void skip_line(FILE *in) {
+  int c;
+  do {
+    c = fgetc(in);
+  } while (c != '\n' && c != EOF);
+}
+
+/* Reader thread: reads the input line by line into free slots
+Modified parameter :
+-void *arg : the stream_pipe
+Return : NULL
+*/
+static void *stream_reader(void *arg) {
+  stream_pipe *sp = arg;
+  char line[STREAM_LINE];
+
+  while (fgets(line, sizeof(line), sp->in)) {
+    size_t len = strlen(line);
+    if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+      skip_line(sp->in);
+      strcpy(line, "?");
+    }
+
+    pthread_mutex_lock(&sp->lock);
+    while (sp->read - sp->written >= STREAM_SLOTS) {
+      pthread_cond_wait(&sp->slot_freed, &sp->lock);
+    }
+    stream_slot *slot = &sp->slots[sp->read % STREAM_SLOTS];
+    pthread_mutex_unlock(&sp->lock);
+
+    /* The slot belongs to the reader until its state says otherwise */
+    memcpy(slot->text, line, strlen(line) + 1);
+
+    pthread_mutex_lock(&sp->lock);
+    slot->state = SLOT_READ;
+    sp->read++;
+    pthread_cond_signal(&sp->puzzle_read);
+    pthread_mutex_unlock(&sp->lock);
+  }
+
+  pthread_mutex_lock(&sp->lock);
+  sp->eof = 1;
+  pthread_cond_broadcast(&sp->puzzle_read);
+  pthread_cond_broadcast(&sp->puzzle_done);
+  pthread_mutex_unlock(&sp->lock);
+  return NULL;
+}
+
+/* Solves the puzzle of a slot and replaces its text with the answer
+Modified parameter :
+-stream_slot *slot : the slot
+*/
+static void solve_slot(stream_slot *slot) {
+  bitgrid bg;
+
+  if (!bitgrid_from_string(&bg, slot->text)) {
+    strcpy(slot->text, "invalid\n");
+  } else if (!bitgrid_solve(&bg) || !bitgrid_is_solved(&bg)) {
+    strcpy(slot->text, "unsolvable\n");
+  } else {
+    bitgrid_to_string(&bg, slot->text);
+    strcat(slot->text, "\n");
+  }
+}
+
+/* Worker thread: solves the read puzzles in input order until the input
+ends
+Modified parameter :
+-void *arg : the stream_pipe
+Return : NULL
+*/
+static void *stream_worker(void *arg) {
+  stream_pipe *sp = arg;
+
+  pthread_mutex_lock(&sp->lock);
+  for (;;) {
+    while (sp->claimed == sp->read && !sp->eof) {
+      pthread_cond_wait(&sp->puzzle_read, &sp->lock);
+    }
+    if (sp->claimed == sp->read) {
+      break;
+    }
+
+    stream_slot *slot = &sp->slots[sp->claimed++ % STREAM_SLOTS];
+    slot->state = SLOT_SOLVING;
+    pthread_mutex_unlock(&sp->lock);
+
+    solve_slot(slot);
+
+    pthread_mutex_lock(&sp->lock);
+    slot->state = SLOT_DONE;
+    pthread_cond_broadcast(&sp->puzzle_done);
+  }
+  pthread_mutex_unlock(&sp->lock);
+
+  stats_flush();
+  return NULL;
+}
+
+/* Solves every puzzle of in and writes the answers to out, in order, with
+threads solver workers
+Modified parameters :
+-FILE *in : the puzzles, one per line
+-FILE *out : receives one line per puzzle
+-long *total : receives the number of puzzles read
+Copied parameter :
+-int threads : the number of solver workers
+Return : long, the number of puzzles that were solved
+*/
+long solve_stream(FILE *in, FILE *out, int threads, long *total) {
+  stream_pipe sp;
+  pthread_t reader;
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+  long solved = 0;
+
+  sp.in = in;
+  sp.slots = calloc(STREAM_SLOTS, sizeof(stream_slot));
+  sp.read = 0;
+  sp.claimed = 0;
+  sp.written = 0;
+  sp.eof = 0;
+  pthread_mutex_init(&sp.lock, NULL);
+  pthread_cond_init(&sp.slot_freed, NULL);
+  pthread_cond_init(&sp.puzzle_read, NULL);
+  pthread_cond_init(&sp.puzzle_done, NULL);
+
+  pthread_create(&reader, NULL, stream_reader, &sp);
+  for (int t = 0; t < threads; t++) {
+    pthread_create(&workers[t], NULL, stream_worker, &sp);
+  }
+
+  /* The calling thread is the writer */
+  pthread_mutex_lock(&sp.lock);
+  for (;;) {
+    stream_slot *slot = &sp.slots[sp.written % STREAM_SLOTS];
+    while (!(sp.written < sp.read && slot->state == SLOT_DONE) &&
+           !(sp.eof && sp.written == sp.read)) {
+      pthread_cond_wait(&sp.puzzle_done, &sp.lock);
+    }
+    if (sp.written == sp.read) {
+      break;
+    }
+    pthread_mutex_unlock(&sp.lock);
+
+    fputs(slot->text, out);
+    solved += slot->text[0] == '0' || slot->text[0] == '1';
+
+    pthread_mutex_lock(&sp.lock);
+    slot->state = SLOT_FREE;
+    sp.written++;
+    pthread_cond_signal(&sp.slot_freed);
+  }
+  pthread_mutex_unlock(&sp.lock);
+  fflush(out);
+  *total = sp.read;
+
+  pthread_join(reader, NULL);
+  for (int t = 0; t < threads; t++) {
+    pthread_join(workers[t], NULL);
+  }
+
+  pthread_cond_destroy(&sp.puzzle_done);
+  pthread_cond_destroy(&sp.puzzle_read);
+  pthread_cond_destroy(&sp.slot_freed);
+  pthread_mutex_destroy(&sp.lock);
+  free(sp.slots);
+  free(workers);
+  return solved;
+}
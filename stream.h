@@ -0,0 +1,8 @@
+#ifndef STREAM_FILE
+#define STREAM_FILE
+
+#include <stdio.h>
+
+long solve_stream(FILE *in, FILE *out, int threads, long *total);
+
+#endif
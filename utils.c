@@ -8,21 +8,60 @@
  *
  * PUBLIC FUNCTIONS:
  *        int **create_grid(int grid_size[2], int initial_value)
+ *        void free_grid(int **grid)
  *        void print_grid(int **grid, int grid_size[2])
  *        int **generate_mask(int grid_size[2])
  *        int **get_grid_from_mask(int **mask,
  *                                int **original_grid,
  *                                int grid_size[2])
+ *        void column_name(int col_idx, char name[3])
+ *        int column_index(const char *name)
  *
  **/
 
 #include "utils.h"
 #include "constants.h"
+#include "render.h"
+#include "rng.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-/** Creates a grid with size grid_size.
+/* Gets the size of the block holding a grid: the row pointers followed by
+the cells, row after row
+Copied parameter :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+Return : size_t, the size in bytes
+*/
+static size_t grid_bytes(int grid_size[2]) {
+  return grid_size[0] * sizeof(int *) +
+         (size_t)grid_size[0] * grid_size[1] * sizeof(int);
+}
+
+/* Lays a grid out in a block of grid_bytes(grid_size) bytes
+Modified parameter :
+-void *block : the memory of the grid
+Copied parameters :
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+-int initial_value : the initial value of each cell of the grid
+Return : int**, the grid, at the start of block
+*/
+static int **place_grid(void *block, int grid_size[2], int initial_value) {
+  int **grid = block;
+  int *cells = (int *)(grid + grid_size[0]);
+
+  for (int i = 0; i < grid_size[0]; i++) {
+    grid[i] = cells + i * grid_size[1];
+    for (int j = 0; j < grid_size[1]; j++) {
+      grid[i][j] = initial_value;
+    }
+  }
+  return grid;
+}
+
+/** Creates a grid with size grid_size, in a single block that free_grid
+releases.
 
 Copied parameters: 
  - int grid_size[2]: contains the size of the grid in the X and Y dimension
@@ -32,18 +71,65 @@ Returns:
  - int**: the resulting grid
 **/
 int **create_grid(int grid_size[2], int initial_value) {
-  int **grid = (int **)malloc(grid_size[0] * sizeof(int *));
+  return place_grid(malloc(grid_bytes(grid_size)), grid_size, initial_value);
+}
 
-  for (int i = 0; i < grid_size[0]; i++) {
-    grid[i] = (int *)malloc(grid_size[1] * sizeof(int));
-    for (int j = 0; j < grid_size[1]; j++) {
-      grid[i][j] = initial_value;
-    }
+/** Frees a grid made by create_grid, generate_grid or one of the mask
+functions.
+
+Modified parameter:
+ - int **grid: the grid, may be NULL
+
+No return
+**/
+void free_grid(int **grid) { free(grid); }
+
+/** Gets the label of a column: A to Z, then AA, AB, ... like a spreadsheet.
+
+Copied parameter:
+ - int col_idx: index of the column
+
+Modified parameter:
+ - char name[3]: receives the label
+
+No return
+**/
+void column_name(int col_idx, char name[3]) {
+  if (col_idx < 26) {
+    name[0] = 'A' + col_idx;
+    name[1] = '\0';
+  } else {
+    name[0] = 'A' + col_idx / 26 - 1;
+    name[1] = 'A' + col_idx % 26;
   }
-  return grid;
+  name[2] = '\0';
+}
+
+/** Gets the index of a column from its label, in upper or lower case.
+
+Copied parameter:
+ - const char *name: the label
+
+Returns:
+ - int: the index of the column, -1 if the label is invalid
+**/
+int column_index(const char *name) {
+  int first = toupper((unsigned char)name[0]);
+  int second = toupper((unsigned char)name[1]);
+
+  if (first < 'A' || first > 'Z') {
+    return -1;
+  }
+  if (second == '\0') {
+    return first - 'A';
+  }
+  if (second < 'A' || second > 'Z' || name[2] != '\0') {
+    return -1;
+  }
+  return (first - 'A' + 1) * 26 + second - 'A';
 }
 
-/** Pretty-prints game and mask grids.
+/** Pretty-prints game and mask grids, with a single write.
 
 Copied parameters:
  - int **grid: 2D grid to pretty-print
@@ -52,54 +138,14 @@ Copied parameters:
 No return
 **/
 void print_grid(int **grid, int grid_size[2]) {
-  printf("\n      ");
-  for (int i = 65; i < 65 + grid_size[1]; i++) {
-    printf("  %c   ", i);
-  }
-  printf("\n     ╔═════");
-  for (int i = 1; i < grid_size[1] - 1; i++) {
-    printf("╦═════");
-  }
-  printf("╦═════╗\n");
-
-  for (int i = 0; i < grid_size[0]; i++) {
-    printf("%02d   ║", i + 1);
-    for (int j = 0; j < grid_size[1]; j++) {
-      if (grid[i][j] == -1) {
-        printf("  *  ║");
-      } else if (grid[i][j] == 1) {
-        printf(YELLOW "  %d  " RESET "║", grid[i][j]);
-      } else if (grid[i][j] == 0) {
-        printf(GREEN "  %d  " RESET "║", grid[i][j]);
-      } else if (grid[i][j] == VALID_MASK) {
-        printf(GREEN " ■■■ " RESET "║");
-      } else {
-        printf("     ║");
-      }
-    }
+  renderer r;
 
-    if (i < grid_size[1] - 1) {
-      printf("\n     ║");
-      for (int j = 0; j < grid_size[1]; j++) {
-        printf("═════");
-        if (j == grid_size[1] - 1) {
-          printf("║");
-        } else {
-          printf("╬");
-        }
-      }
-    }
-    printf("\n");
-  }
-
-  printf("     ╚═════");
-  for (int i = 1; i < grid_size[1] - 1; i++) {
-    printf("╩═════");
-  }
-  printf("╩═════╝\n");
+  renderer_init(&r, grid_size, 0);
+  render_grid(&r, grid);
+  renderer_free(&r);
 }
 
-/** Generates a random mask.
+/** Generates a random mask, with the generator of the calling thread.
 
 Copied parameter: 
  - int grid_size[2]: contains the size of the grid in the X and Y dimension
@@ -109,10 +155,11 @@ Returns:
 **/
 int **generate_mask(int grid_size[2]) {
   int **mask = create_grid(grid_size, INVALID_MASK);
+  rng *random = rng_thread();
 
   for (int i = 0; i < grid_size[0]; i++) {
     for (int j = 0; j < grid_size[1]; j++) {
-      mask[i][j] = (rand() % 2) ? VALID_MASK : INVALID_MASK;
+      mask[i][j] = rng_int(random, 2) ? VALID_MASK : INVALID_MASK;
     }
   }
   return mask;
@@ -128,17 +175,21 @@ Returns:
 **/
 int **generate_mask_from_user(int grid_size[2]) {
   int **mask = create_grid(grid_size, INVALID_MASK);
+  renderer r;
 
+  renderer_init(&r, grid_size, 1);
   for (int i = 0; i < grid_size[0]; i++) {
     for (int j = 0; j < grid_size[1]; j++) {
       mask[i][j] = -1;
       printf(BLU "\nCurrent mask\n" RESET);
-      print_grid(mask, grid_size);
+      render_grid(&r, mask);
 
       int choice;
-      printf(CYN "\nDo you want to hide the game grid at (%02d,%c) during the "
+      char name[3];
+      column_name(j, name);
+      printf(CYN "\nDo you want to hide the game grid at (%02d,%s) during the "
                  "game? (0 = hide, 1 = show)\n\n" RESET,
-             i + 1, j + 65);
+             i + 1, name);
       do {
         scanf("%d", &choice);
         if (choice != 1 && choice != 0) {
@@ -148,6 +199,7 @@ int **generate_mask_from_user(int grid_size[2]) {
       mask[i][j] = choice ? VALID_MASK : INVALID_MASK;
     }
   }
+  renderer_free(&r);
 
   printf(GREEN "\nHere is your generated mask!\n" RESET);
   print_grid(mask, grid_size);
@@ -202,10 +254,11 @@ Copied parameters :
   in-t **grid, a 2D array which represents the grid
 int col_idx, index in the colunm in the grid
 int col_size, the size of an array column
+Modified parameter :
+int *column, receives the col_size cells of the column
 Return : int* column
 */
-int *get_column(int **grid, int col_idx, int col_size) {
-  int *column = malloc(sizeof(int) * col_size);
+int *get_column(int **grid, int col_idx, int col_size, int *column) {
   for (int i = 0; i < col_size; i++) {
     column[i] = grid[i][col_idx];
   }
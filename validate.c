@@ -0,0 +1,270 @@
+/**
+ * FILENAME: validate.c
+ *
+ * AUTHORS: Audrey Damiba & Melissa Lacheb
+ *
+ * DESCRIPTION:
+ *        Validation of many completed grids at once: no triple, as many
+ *        zeros as ones and no repeated line, in every row and column. The
+ *        rules are written once on vectors of 64-bit lanes (one grid per
+ *        lane) in validate_kernel.h and compiled for AVX2, SSE4.2 and plain
+ *        64-bit code, once for any size and once for each square size from
+ *        4 to 16 with unrolled loops; the widest kernel the processor
+ *        supports is chosen at run time, then the kernel of the size. The
+ *        first failing grid is checked again by the scalar diagnostic,
+ *        which tells which rule it breaks and where.
+ *
+ * PUBLIC FUNCTIONS:
+ *        long validate_batch(const line_t *rows, long count,
+ *                            int grid_size[2], uint64_t *pass,
+ *                            grid_violation *first)
+ *        int validate_grid(const line_t *rows, int grid_size[2],
+ *                          grid_violation *violation)
+ *        const char *validation_kernel(void)
+ *        const char *violation_name(int kind)
+ *
+ **/
+
+#include "validate.h"
+#include "kernels.h"
+#include "line_set.h"
+
+#include <string.h>
+
+typedef void (*validate_fn)(const line_t *rows, long first, long count,
+                            int grid_size[2], uint64_t *pass);
+
+#define KERNEL_PREFIX validate_scalar
+#define KERNEL_POPCOUNT popcount_scalar
+#define KERNEL_VEC vec_scalar
+#define KERNEL_LANES 1
+#define KERNEL_TARGET
+#include "validate_sizes.h"
+
+#if defined(__x86_64__)
+#define KERNEL_PREFIX validate_sse
+#define KERNEL_POPCOUNT popcount_sse
+#define KERNEL_VEC vec_sse
+#define KERNEL_LANES 2
+#define KERNEL_TARGET __attribute__((target("sse4.2")))
+#include "validate_sizes.h"
+
+#define KERNEL_PREFIX validate_avx2
+#define KERNEL_POPCOUNT popcount_avx2
+#define KERNEL_VEC vec_avx2
+#define KERNEL_LANES 4
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#include "validate_sizes.h"
+#endif
+
+typedef struct validation_kernel_info {
+  const char *name;
+  int lanes;
+  validate_fn run;
+  const validate_fn *sized;
+} validation_kernel_info;
+
+/* Picks the widest kernel supported by the processor
+Return : const validation_kernel_info *, the kernel
+*/
+static const validation_kernel_info *select_kernel(void) {
+  static const validation_kernel_info scalar = {"scalar", 1, validate_scalar_any,
+                                                validate_scalar_sizes};
+#if defined(__x86_64__)
+  static const validation_kernel_info sse = {"sse4.2", 2, validate_sse_any,
+                                             validate_sse_sizes};
+  static const validation_kernel_info avx2 = {"avx2", 4, validate_avx2_any,
+                                              validate_avx2_sizes};
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &avx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return &sse;
+  }
+#endif
+  return &scalar;
+}
+
+/* Kernel chosen at the first call, the same for every thread afterwards */
+static const validation_kernel_info *current_kernel(void) {
+  static const validation_kernel_info *_Atomic kernel = NULL;
+  const validation_kernel_info *k = kernel;
+
+  if (!k) {
+    k = select_kernel();
+    kernel = k;
+  }
+  return k;
+}
+
+/* Name of the kernel used by validate_batch ("avx2", "sse4.2" or "scalar")
+Return : const char *, the name
+*/
+const char *validation_kernel(void) { return current_kernel()->name; }
+
+/* Name of a kind of violation
+Copied parameter :
+-int kind : a VIOLATION_* constant
+Return : const char *, the name
+*/
+const char *violation_name(int kind) {
+  static const char *names[] = {"none",           "row triple",
+                                "column triple",  "row balance",
+                                "column balance", "repeated row",
+                                "repeated column"};
+
+  if (kind < VIOLATION_NONE || kind > VIOLATION_COLUMN_DUPLICATE) {
+    return "unknown";
+  }
+  return names[kind];
+}
+
+/* Checks the triples and the balance of one completed line
+Copied parameters :
+-line_t line : the line, bit i holds cell i
+-int line_size : the number of cells in the line
+Return : int, 0 if valid, 1 for a triple, 2 for a wrong number of ones
+*/
+static int line_violation(line_t line, int line_size) {
+  line_t zeros = ~line & line_mask(line_size);
+
+  if ((line & (line >> 1) & (line >> 2)) ||
+      (zeros & (zeros >> 1) & (zeros >> 2))) {
+    return 1;
+  }
+  if (line_size % 2 || __builtin_popcountll(line) != line_size / 2) {
+    return 2;
+  }
+  return 0;
+}
+
+/* Looks for the first line of lines equal to an earlier one
+Copied parameters :
+-const line_t *lines : the lines
+-int count : the number of lines
+Return : int, index of the repeated line, -1 if every line is different
+*/
+static int repeated_line(const line_t *lines, int count) {
+  line_set seen;
+
+  line_set_clear(&seen);
+  for (int i = 0; i < count; i++) {
+    if (!line_set_insert(&seen, lines[i])) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Checks one completed grid and tells the first rule it breaks: triples and
+balance of the rows, then of the columns, then repeated rows and columns
+Copied parameters :
+-const line_t *rows : the grid_size[0] rows of the grid, bit j holds column j
+-int grid_size[2] : contains the size of the grid in the X and Y dimension
+Modified parameter :
+-grid_violation *violation : receives the kind and the line of the violation,
+ may be NULL; its grid is left unchanged
+Return : int, 1 if the grid is valid
+*/
+int validate_grid(const line_t *rows, int grid_size[2],
+                  grid_violation *violation) {
+  line_t full = line_mask(grid_size[1]);
+  line_t masked[MAX_GRID_SIZE];
+  line_t cols[MAX_GRID_SIZE];
+  int kind = VIOLATION_NONE, line = -1;
+
+  memset(cols, 0, sizeof(cols));
+  for (int i = 0; i < grid_size[0]; i++) {
+    masked[i] = rows[i] & full;
+    for (line_t bits = masked[i]; bits; bits &= bits - 1) {
+      cols[__builtin_ctzll(bits)] |= (line_t)1 << i;
+    }
+  }
+
+  for (int i = 0; i < grid_size[0] && !kind; i++) {
+    int error = line_violation(masked[i], grid_size[1]);
+    if (error) {
+      kind = error == 1 ? VIOLATION_ROW_TRIPLE : VIOLATION_ROW_BALANCE;
+      line = i;
+    }
+  }
+  for (int j = 0; j < grid_size[1] && !kind; j++) {
+    int error = line_violation(cols[j], grid_size[0]);
+    if (error) {
+      kind = error == 1 ? VIOLATION_COLUMN_TRIPLE : VIOLATION_COLUMN_BALANCE;
+      line = j;
+    }
+  }
+  if (!kind && (line = repeated_line(masked, grid_size[0])) >= 0) {
+    kind = VIOLATION_ROW_DUPLICATE;
+  }
+  if (!kind && (line = repeated_line(cols, grid_size[1])) >= 0) {
+    kind = VIOLATION_COLUMN_DUPLICATE;
+  }
+
+  if (violation) {
+    violation->kind = kind;
+    violation->line = kind ? line : -1;
+  }
+  return !kind;
+}
+
+/* Checks count completed grids of the same size with the widest kernel of
+the processor, several grids per instruction
+Copied parameters :
+-const line_t *rows : the rows of every grid, grid after grid (grid g starts
+ at rows[g * grid_size[0]]), bit j of a row holds column j
+-long count : the number of grids
+-int grid_size[2] : contains the size of the grids in the X and Y dimension
+Modified parameters :
+-uint64_t *pass : (count + 63) / 64 words, bit g is set when grid g is valid
+-grid_violation *first : receives the first invalid grid and what it breaks,
+ grid -1 when every grid is valid; may be NULL
+Return : long, the number of valid grids
+*/
+long validate_batch(const line_t *rows, long count, int grid_size[2],
+                    uint64_t *pass, grid_violation *first) {
+  const validation_kernel_info *kernel = current_kernel();
+  long words = (count + 63) / 64;
+  long valid = 0;
+
+  memset(pass, 0, words * sizeof(uint64_t));
+  if (grid_size[0] % 2 == 0 && grid_size[1] % 2 == 0) {
+    validate_fn run = kernel->run, tail = validate_scalar_any;
+    if (specialized_kernels() && grid_size[0] == grid_size[1] &&
+        grid_size[0] >= SPECIALIZED_MIN_SIZE &&
+        grid_size[0] <= SPECIALIZED_MAX_SIZE) {
+      run = kernel->sized[grid_size[0] / 2];
+      tail = validate_scalar_sizes[grid_size[0] / 2];
+    }
+
+    long wide = count - count % kernel->lanes;
+    run(rows, 0, wide, grid_size, pass);
+    tail(rows, wide, count - wide, grid_size, pass);
+  }
+
+  for (long w = 0; w < words; w++) {
+    valid += __builtin_popcountll(pass[w]);
+  }
+
+  if (first) {
+    first->grid = -1;
+    first->kind = VIOLATION_NONE;
+    first->line = -1;
+    for (long w = 0; w < words; w++) {
+      uint64_t failed = ~pass[w];
+      if (w == words - 1 && count % 64) {
+        failed &= ((uint64_t)1 << (count % 64)) - 1;
+      }
+      if (failed) {
+        first->grid = w * 64 + __builtin_ctzll(failed);
+        validate_grid(rows + first->grid * grid_size[0], grid_size, first);
+        break;
+      }
+    }
+  }
+
+  return valid;
+}
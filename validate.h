@@ -0,0 +1,29 @@
+#ifndef VALIDATE_FILE
+#define VALIDATE_FILE
+
+#include "bitboard.h"
+
+#define VIOLATION_NONE 0
+#define VIOLATION_ROW_TRIPLE 1
+#define VIOLATION_COLUMN_TRIPLE 2
+#define VIOLATION_ROW_BALANCE 3
+#define VIOLATION_COLUMN_BALANCE 4
+#define VIOLATION_ROW_DUPLICATE 5
+#define VIOLATION_COLUMN_DUPLICATE 6
+
+/* A broken rule of a completed grid: the grid of the batch, the kind of
+violation (VIOLATION_*) and the row or column where it was found */
+typedef struct grid_violation {
+  long grid;
+  int kind;
+  int line;
+} grid_violation;
+
+long validate_batch(const line_t *rows, long count, int grid_size[2],
+                    uint64_t *pass, grid_violation *first);
+int validate_grid(const line_t *rows, int grid_size[2],
+                  grid_violation *violation);
+const char *validation_kernel(void);
+const char *violation_name(int kind);
+
+#endif
@@ -0,0 +1,94 @@
+/* Body of a batch validation kernel, included by validate_sizes.h with
+KERNEL_NAME, KERNEL_POPCOUNT, KERNEL_VEC, KERNEL_LANES (grids checked
+together, one per 64-bit lane) and KERNEL_TARGET (a target attribute, or
+nothing) defined, and KERNEL_SIZE too for a kernel that only handles square
+grids of that size, with constant bounds. Every rule is evaluated on whole
+rows with shifts, ANDs and XORs, so a lane never branches on its own grid */
+
+/* Checks count grids (a multiple of KERNEL_LANES) from grid first, and sets
+their bit of pass when they are valid. Sizes are even
+Copied parameters :
+-const line_t *rows : the rows of every grid, grid after grid
+-long first, long count : the grids to check
+-int grid_size[2] : contains the size of the grids in the X and Y dimension
+Modified parameter :
+-uint64_t *pass : bit g is set when grid g is valid
+*/
+KERNEL_TARGET static void KERNEL_NAME(const line_t *rows, long first,
+                                      long count, int grid_size[2],
+                                      uint64_t *pass) {
+#ifdef KERNEL_SIZE
+  const int n_rows = KERNEL_SIZE, n_cols = KERNEL_SIZE;
+  (void)grid_size;
+#else
+  int n_rows = grid_size[0], n_cols = grid_size[1];
+#endif
+  line_t full = line_mask(n_cols);
+  KERNEL_VEC v[MAX_GRID_SIZE];
+
+  for (long g = first; g < first + count; g += KERNEL_LANES) {
+    KERNEL_VEC bad = {0};
+    KERNEL_VEC slices[7] = {{0}};
+
+    for (int i = 0; i < n_rows; i++) {
+      for (int k = 0; k < KERNEL_LANES; k++) {
+        v[i][k] = rows[(g + k) * n_rows + i] & full;
+      }
+
+      /* Row triples and balance */
+      KERNEL_VEC zeros = ~v[i] & full;
+      bad |= v[i] & (v[i] >> 1) & (v[i] >> 2);
+      bad |= zeros & (zeros >> 1) & (zeros >> 2);
+      bad |= (KERNEL_VEC)(KERNEL_POPCOUNT(v[i]) != (line_t)(n_cols / 2));
+
+      /* Column triples: three rows in a row that agree on a column */
+      if (i >= 2) {
+        bad |= v[i - 2] & v[i - 1] & v[i];
+        bad |= ~(v[i - 2] | v[i - 1] | v[i]) & full;
+      }
+
+      /* Column balance: one counter per column, bit-sliced (slice b holds
+      bit b of every count) and incremented by a ripple of ANDs and XORs */
+      KERNEL_VEC carry = v[i];
+      for (int b = 0; b < 7; b++) {
+        KERNEL_VEC next = slices[b] & carry;
+        slices[b] ^= carry;
+        carry = next;
+      }
+
+      /* Repeated rows */
+      for (int k = 0; k < i; k++) {
+        bad |= (KERNEL_VEC)(v[k] == v[i]);
+      }
+    }
+
+    KERNEL_VEC balanced = (KERNEL_VEC){0} + full;
+    for (int b = 0; b < 7; b++) {
+      balanced &= ((n_rows / 2) >> b) & 1 ? slices[b] : ~slices[b];
+    }
+    bad |= ~balanced & full;
+
+    /* Repeated columns: columns j and j + d are equal when no row has
+    different bits at j and j + d. This is the loop worth unrolling: the
+    shifts become constants and the rows stay in registers */
+#ifdef KERNEL_SIZE
+#pragma GCC unroll 16
+#endif
+    for (int d = 1; d < n_cols; d++) {
+      KERNEL_VEC differ = {0};
+      for (int i = 0; i < n_rows; i++) {
+        differ |= v[i] ^ (v[i] >> d);
+      }
+      bad |= ~differ & line_mask(n_cols - d);
+    }
+
+    for (int k = 0; k < KERNEL_LANES; k++) {
+      if (!bad[k]) {
+        pass[(g + k) >> 6] |= (uint64_t)1 << ((g + k) & 63);
+      }
+    }
+  }
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_SIZE
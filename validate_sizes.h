@@ -0,0 +1,71 @@
+/* Batch validation kernels of one instruction set, included by validate.c
+with KERNEL_PREFIX, KERNEL_POPCOUNT, KERNEL_VEC, KERNEL_LANES and
+KERNEL_TARGET defined (see validate_kernel.h). Defines the vector type, its
+popcount, the generic kernel <prefix>_any, one kernel per even square size
+from SPECIALIZED_MIN_SIZE to SPECIALIZED_MAX_SIZE and their table
+<prefix>_sizes, indexed by half the size */
+
+#define KERNEL_JOIN2(prefix, suffix) prefix##_##suffix
+#define KERNEL_JOIN(prefix, suffix) KERNEL_JOIN2(prefix, suffix)
+
+typedef uint64_t KERNEL_VEC __attribute__((vector_size(8 * KERNEL_LANES)));
+
+/* Number of set bits of each lane, without a popcount instruction */
+KERNEL_TARGET static inline KERNEL_VEC KERNEL_POPCOUNT(KERNEL_VEC x) {
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  x = x + (x >> 8);
+  x = x + (x >> 16);
+  x = x + (x >> 32);
+  return x & 0x7F;
+}
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, any)
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 4)
+#define KERNEL_SIZE 4
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 6)
+#define KERNEL_SIZE 6
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 8)
+#define KERNEL_SIZE 8
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 10)
+#define KERNEL_SIZE 10
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 12)
+#define KERNEL_SIZE 12
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 14)
+#define KERNEL_SIZE 14
+#include "validate_kernel.h"
+
+#define KERNEL_NAME KERNEL_JOIN(KERNEL_PREFIX, 16)
+#define KERNEL_SIZE 16
+#include "validate_kernel.h"
+
+static const validate_fn
+    KERNEL_JOIN(KERNEL_PREFIX, sizes)[SPECIALIZED_MAX_SIZE / 2 + 1] = {
+        NULL,
+        NULL,
+        KERNEL_JOIN(KERNEL_PREFIX, 4),
+        KERNEL_JOIN(KERNEL_PREFIX, 6),
+        KERNEL_JOIN(KERNEL_PREFIX, 8),
+        KERNEL_JOIN(KERNEL_PREFIX, 10),
+        KERNEL_JOIN(KERNEL_PREFIX, 12),
+        KERNEL_JOIN(KERNEL_PREFIX, 14),
+        KERNEL_JOIN(KERNEL_PREFIX, 16)};
+
+#undef KERNEL_PREFIX
+#undef KERNEL_POPCOUNT
+#undef KERNEL_VEC
+#undef KERNEL_LANES
+#undef KERNEL_TARGET